@@ -0,0 +1,736 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <barrier>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+/*
+ * Иерархии сжатия (Contraction Hierarchies).
+ * При построении вершины по очереди «стягиваются» от наименее важных к наиболее важным,
+ * а кратчайшие пути, проходившие через стянутую вершину, заменяются рёбрами-сокращениями.
+ * Запрос — двунаправленный поиск Дейкстры, в котором оба направления идут только
+ * к более важным вершинам. Найденные сокращения разворачиваются в рёбра исходного графа,
+ * поэтому путь возвращается в тех же EdgeId, что и у graph::Router
+ */
+template <typename Weight>
+class ContractionHierarchies {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    struct Path {
+        Weight weight;
+        std::vector<EdgeId> edges;
+    };
+
+    // Поиски путей-свидетелей у вершин с большим числом входящих рёбер идут в thread_count потоков.
+    // Порядок стягивания и сокращения от числа потоков не зависят
+    explicit ContractionHierarchies(const Graph& graph, size_t thread_count = 1);
+
+    std::optional<Path> FindPath(VertexId from, VertexId to) const;
+
+    // Веса кратчайших путей между всеми парами (source, target) алгоритмом с корзинами:
+    // обратные поиски от целей раскладывают достигнутые веса по вершинам,
+    // а прямой поиск от каждого источника лишь просматривает корзины своих вершин
+    std::vector<std::vector<std::optional<Weight>>> FindWeights(const std::vector<VertexId>& sources,
+                                                                const std::vector<VertexId>& targets) const;
+
+    // Сохранение и восстановление готовой иерархии без повторного стягивания вершин.
+    // Load проверяет прочитанное по graph, для которого иерархия строилась: испорченный файл
+    // даёт исключение, а не выход за границы массивов при поиске
+    template <typename Archive>
+    void Save(Archive& archive) const;
+    template <typename Archive>
+    static ContractionHierarchies Load(Archive& archive, const Graph& graph);
+
+private:
+    ContractionHierarchies() = default;
+
+    static constexpr size_t NO_EDGE = std::numeric_limits<size_t>::max();
+    // Ограничение числа вершин, просматриваемых при поиске пути-свидетеля.
+    // Если свидетель не найден в пределах ограничения, добавляется лишнее, но корректное сокращение
+    static constexpr size_t WITNESS_SETTLED_LIMIT = 100;
+    // С какого числа входящих рёбер поиски свидетелей вершины делятся между потоками.
+    // У большинства вершин рёбер мало, а основное время уходит на плотное ядро из последних вершин
+    static constexpr size_t PARALLEL_WITNESS_MIN_IN_EDGES = 8;
+
+    // Ребро иерархии: либо ребро исходного графа, либо сокращение из двух рёбер иерархии
+    struct HierarchyEdge {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        EdgeId original_edge = NO_EDGE;
+        size_t first_half = NO_EDGE;
+        size_t second_half = NO_EDGE;
+    };
+
+    // Ребро графа поиска: вершина, в которую ведёт поиск, и номер ребра иерархии
+    struct SearchEdge {
+        VertexId to;
+        Weight weight;
+        size_t hierarchy_edge;
+    };
+
+    // Состояние, нужное только на время стягивания вершин
+    struct ContractionState {
+        std::vector<std::vector<size_t>> out_edges;
+        std::vector<std::vector<size_t>> in_edges;
+        std::vector<bool> contracted;
+        std::vector<int> contracted_neighbors;
+    };
+
+    // Веса поиска свидетелей. У каждого потока свои, граф стягивания при поиске только читается
+    struct WitnessSpace {
+        explicit WitnessSpace(size_t vertex_count)
+            : weights(vertex_count) {
+        }
+
+        std::vector<std::optional<Weight>> weights;
+        std::vector<VertexId> touched;
+    };
+
+    // Потоки поиска свидетелей, создаваемые один раз на всё стягивание. Run раздаёт задачу через барьер:
+    // каждый поток, включая вызывающий, выполняет task(thread_index), и Run возвращается, когда закончат все
+    class WitnessWorkers {
+    public:
+        explicit WitnessWorkers(size_t thread_count)
+            : thread_count_(std::max<size_t>(1, thread_count))
+            , sync_point_(static_cast<std::ptrdiff_t>(thread_count_)) {
+            workers_.reserve(thread_count_ - 1);
+            for (size_t thread_index = 0; thread_index + 1 < thread_count_; ++thread_index) {
+                workers_.emplace_back([this, thread_index] {
+                    while (true) {
+                        sync_point_.arrive_and_wait();
+                        if (is_stopped_) {
+                            return;
+                        }
+                        (*task_)(thread_index);
+                        sync_point_.arrive_and_wait();
+                    }
+                });
+            }
+        }
+
+        WitnessWorkers(const WitnessWorkers&) = delete;
+        WitnessWorkers& operator=(const WitnessWorkers&) = delete;
+
+        ~WitnessWorkers() {
+            is_stopped_ = true;
+            sync_point_.arrive_and_wait();
+            for (std::thread& worker : workers_) {
+                worker.join();
+            }
+        }
+
+        size_t GetThreadCount() const {
+            return thread_count_;
+        }
+
+        void Run(const std::function<void(size_t)>& task) {
+            task_ = &task;
+            sync_point_.arrive_and_wait();
+            task(thread_count_ - 1);
+            sync_point_.arrive_and_wait();
+        }
+
+    private:
+        size_t thread_count_;
+        std::barrier<> sync_point_;
+        // Пишутся вызывающим потоком до барьера и читаются потоками после него
+        const std::function<void(size_t)>* task_ = nullptr;
+        bool is_stopped_ = false;
+        std::vector<std::thread> workers_;
+    };
+
+    // Результат одного направления поиска. Пространство переиспользуется между поисками:
+    // Prepare сбрасывает веса только у вершин, достигнутых прошлым поиском, поэтому подготовка
+    // стоит столько же, сколько сам поиск, а не O(V)
+    struct SearchSpace {
+        void Prepare(size_t vertex_count) {
+            if (weights.size() < vertex_count) {
+                weights.resize(vertex_count);
+                parent_edges.resize(vertex_count, NO_EDGE);
+            }
+            for (const VertexId vertex : touched) {
+                weights[vertex].reset();
+            }
+            touched.clear();
+        }
+
+        // Записывает вес вершины, запоминая впервые достигнутые вершины для следующего Prepare
+        void SetWeight(VertexId vertex, Weight weight) {
+            if (!weights[vertex]) {
+                touched.push_back(vertex);
+            }
+            weights[vertex] = weight;
+        }
+
+        std::vector<std::optional<Weight>> weights;
+        std::vector<size_t> parent_edges;
+        std::vector<VertexId> touched;
+    };
+
+    using QueueItem = std::pair<Weight, VertexId>;
+    using Queue = std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>>;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    size_t vertex_count_ = 0;
+    std::vector<HierarchyEdge> edges_;
+    std::vector<size_t> ranks_;
+    // Рёбра к более важным вершинам в CSR-виде: прямой поиск идёт по ним от источника,
+    // обратный — по развёрнутым рёбрам от цели
+    std::vector<size_t> forward_offsets_;
+    std::vector<SearchEdge> forward_edges_;
+    std::vector<size_t> backward_offsets_;
+    std::vector<SearchEdge> backward_edges_;
+
+    // Оставляет для каждой соседней вершины только самое лёгкое ребро
+    std::vector<size_t> GetLightestEdgesToNeighbors(const ContractionState& state,
+                                                    const std::vector<size_t>& edge_ids,
+                                                    bool by_source, VertexId vertex) const;
+    void RunWitnessSearch(const ContractionState& state, WitnessSpace& witness, VertexId source, VertexId excluded,
+                          Weight max_weight) const;
+    // Сокращения через vertex, начинающиеся входящим ребром in_edge
+    void AppendShortcuts(const ContractionState& state, WitnessSpace& witness, VertexId vertex, size_t in_edge,
+                         const std::vector<size_t>& out_edges, Weight max_out_weight,
+                         std::vector<HierarchyEdge>& shortcuts) const;
+    std::vector<HierarchyEdge> FindShortcuts(const ContractionState& state, std::vector<WitnessSpace>& witness_spaces,
+                                             WitnessWorkers& workers, VertexId vertex) const;
+    bool IsConsistentWith(const Graph& graph) const;
+    bool AreSearchEdgesConsistent(const std::vector<size_t>& offsets, const std::vector<SearchEdge>& search_edges) const;
+    int ComputePriority(const ContractionState& state, VertexId vertex,
+                        const std::vector<HierarchyEdge>& shortcuts) const;
+    void Contract(size_t thread_count);
+    void BuildSearchGraphs();
+
+    // Полный поиск только к более важным вершинам. Возвращает вершины и найденные до них веса.
+    // space готовится перед поиском, поэтому один space годится для серии поисков
+    std::vector<std::pair<VertexId, Weight>> SearchUpward(VertexId start, bool is_forward, SearchSpace& space) const;
+
+    void AppendUnpackedEdges(size_t hierarchy_edge, std::vector<EdgeId>& edges) const;
+};
+
+template <typename Weight>
+ContractionHierarchies<Weight>::ContractionHierarchies(const Graph& graph, size_t thread_count)
+    : vertex_count_(graph.GetVertexCount())
+    , ranks_(graph.GetVertexCount())
+{
+    edges_.reserve(graph.GetEdgeCount());
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const Edge<Weight>& edge = graph.GetEdge(edge_id);
+        if (edge.weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        edges_.push_back(HierarchyEdge{edge.from, edge.to, edge.weight, edge_id});
+    }
+
+    Contract(thread_count);
+    BuildSearchGraphs();
+}
+
+template <typename Weight>
+template <typename Archive>
+void ContractionHierarchies<Weight>::Save(Archive& archive) const {
+    archive.Write(static_cast<uint64_t>(vertex_count_));
+    archive.WriteVector(edges_);
+    archive.WriteVector(ranks_);
+    archive.WriteVector(forward_offsets_);
+    archive.WriteVector(forward_edges_);
+    archive.WriteVector(backward_offsets_);
+    archive.WriteVector(backward_edges_);
+}
+
+template <typename Weight>
+template <typename Archive>
+ContractionHierarchies<Weight> ContractionHierarchies<Weight>::Load(Archive& archive, const Graph& graph) {
+    ContractionHierarchies hierarchies;
+    hierarchies.vertex_count_ = archive.template Read<uint64_t>();
+    hierarchies.edges_ = archive.template ReadVector<HierarchyEdge>();
+    hierarchies.ranks_ = archive.template ReadVector<size_t>();
+    hierarchies.forward_offsets_ = archive.template ReadVector<size_t>();
+    hierarchies.forward_edges_ = archive.template ReadVector<SearchEdge>();
+    hierarchies.backward_offsets_ = archive.template ReadVector<size_t>();
+    hierarchies.backward_edges_ = archive.template ReadVector<SearchEdge>();
+    if (!hierarchies.IsConsistentWith(graph)) {
+        throw std::invalid_argument("Saved contraction hierarchies are inconsistent");
+    }
+    return hierarchies;
+}
+
+template <typename Weight>
+bool ContractionHierarchies<Weight>::IsConsistentWith(const Graph& graph) const {
+    if (vertex_count_ != graph.GetVertexCount() || edges_.size() < graph.GetEdgeCount() || ranks_.size() != vertex_count_) {
+        return false;
+    }
+    // Первые рёбра иерархии — рёбра графа в порядке EdgeId, за ними сокращения.
+    // Половины сокращения добавлены раньше него, поэтому разворачивание пути не зацикливается
+    for (size_t edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+        const HierarchyEdge& edge = edges_[edge_id];
+        if (edge.from >= vertex_count_ || edge.to >= vertex_count_) {
+            return false;
+        }
+        const bool is_original = edge_id < graph.GetEdgeCount();
+        if (is_original ? edge.original_edge != edge_id
+                        : edge.original_edge != NO_EDGE || edge.first_half >= edge_id || edge.second_half >= edge_id) {
+            return false;
+        }
+    }
+    return AreSearchEdgesConsistent(forward_offsets_, forward_edges_)
+        && AreSearchEdgesConsistent(backward_offsets_, backward_edges_);
+}
+
+template <typename Weight>
+bool ContractionHierarchies<Weight>::AreSearchEdgesConsistent(const std::vector<size_t>& offsets,
+                                                              const std::vector<SearchEdge>& search_edges) const {
+    if (offsets.size() != vertex_count_ + 1 || offsets.front() != 0 || offsets.back() != search_edges.size()
+        || !std::is_sorted(offsets.begin(), offsets.end()))
+    {
+        return false;
+    }
+    return std::all_of(search_edges.begin(), search_edges.end(), [this](const SearchEdge& edge) {
+        return edge.to < vertex_count_ && edge.hierarchy_edge < edges_.size();
+    });
+}
+
+template <typename Weight>
+std::vector<size_t> ContractionHierarchies<Weight>::GetLightestEdgesToNeighbors(
+    const ContractionState& state, const std::vector<size_t>& edge_ids, bool by_source, VertexId vertex
+) const {
+    std::vector<size_t> lightest_edges;
+    for (const size_t edge_id : edge_ids) {
+        const HierarchyEdge& edge = edges_[edge_id];
+        const VertexId neighbor = by_source ? edge.from : edge.to;
+        if (neighbor != vertex && !state.contracted[neighbor]) {
+            lightest_edges.push_back(edge_id);
+        }
+    }
+    std::sort(lightest_edges.begin(), lightest_edges.end(), [&](size_t lhs, size_t rhs) {
+        const VertexId lhs_neighbor = by_source ? edges_[lhs].from : edges_[lhs].to;
+        const VertexId rhs_neighbor = by_source ? edges_[rhs].from : edges_[rhs].to;
+        return std::pair{lhs_neighbor, edges_[lhs].weight} < std::pair{rhs_neighbor, edges_[rhs].weight};
+    });
+    lightest_edges.erase(std::unique(lightest_edges.begin(), lightest_edges.end(), [&](size_t lhs, size_t rhs) {
+        return by_source ? edges_[lhs].from == edges_[rhs].from : edges_[lhs].to == edges_[rhs].to;
+    }), lightest_edges.end());
+    return lightest_edges;
+}
+
+template <typename Weight>
+void ContractionHierarchies<Weight>::RunWitnessSearch(const ContractionState& state, WitnessSpace& witness,
+                                                      VertexId source, VertexId excluded, Weight max_weight) const {
+    for (const VertexId vertex : witness.touched) {
+        witness.weights[vertex].reset();
+    }
+    witness.touched.clear();
+
+    Queue queue;
+    witness.weights[source] = ZERO_WEIGHT;
+    witness.touched.push_back(source);
+    queue.push({ZERO_WEIGHT, source});
+    size_t settled_count = 0;
+    while (!queue.empty() && settled_count < WITNESS_SETTLED_LIMIT) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (*witness.weights[vertex] < weight) {
+            continue;
+        }
+        if (max_weight < weight) {
+            break;
+        }
+        ++settled_count;
+        for (const size_t edge_id : state.out_edges[vertex]) {
+            const HierarchyEdge& edge = edges_[edge_id];
+            if (edge.to == excluded || state.contracted[edge.to]) {
+                continue;
+            }
+            const Weight candidate_weight = weight + edge.weight;
+            auto& weight_to = witness.weights[edge.to];
+            if (!weight_to || candidate_weight < *weight_to) {
+                if (!weight_to) {
+                    witness.touched.push_back(edge.to);
+                }
+                weight_to = candidate_weight;
+                queue.push({candidate_weight, edge.to});
+            }
+        }
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchies<Weight>::AppendShortcuts(const ContractionState& state, WitnessSpace& witness,
+                                                     VertexId vertex, size_t in_edge,
+                                                     const std::vector<size_t>& out_edges, Weight max_out_weight,
+                                                     std::vector<HierarchyEdge>& shortcuts) const {
+    const VertexId from = edges_[in_edge].from;
+    RunWitnessSearch(state, witness, from, vertex, edges_[in_edge].weight + max_out_weight);
+    for (const size_t out_edge : out_edges) {
+        const VertexId to = edges_[out_edge].to;
+        if (to == from) {
+            continue;
+        }
+        const Weight shortcut_weight = edges_[in_edge].weight + edges_[out_edge].weight;
+        const auto& witness_weight = witness.weights[to];
+        if (!witness_weight || shortcut_weight < *witness_weight) {
+            shortcuts.push_back(HierarchyEdge{from, to, shortcut_weight, NO_EDGE, in_edge, out_edge});
+        }
+    }
+}
+
+template <typename Weight>
+std::vector<typename ContractionHierarchies<Weight>::HierarchyEdge>
+ContractionHierarchies<Weight>::FindShortcuts(const ContractionState& state, std::vector<WitnessSpace>& witness_spaces,
+                                              WitnessWorkers& workers, VertexId vertex) const {
+    const std::vector<size_t> in_edges = GetLightestEdgesToNeighbors(state, state.in_edges[vertex], true, vertex);
+    const std::vector<size_t> out_edges = GetLightestEdgesToNeighbors(state, state.out_edges[vertex], false, vertex);
+
+    if (out_edges.empty()) {
+        return {};
+    }
+    Weight max_out_weight = ZERO_WEIGHT;
+    for (const size_t out_edge : out_edges) {
+        max_out_weight = std::max(max_out_weight, edges_[out_edge].weight);
+    }
+
+    // Поиски от разных входящих рёбер независимы. Каждый поток берёт непрерывный диапазон рёбер,
+    // а сокращения склеиваются в порядке рёбер, как при поиске в одном потоке
+    const size_t thread_count = in_edges.size() < PARALLEL_WITNESS_MIN_IN_EDGES
+        ? 1 : std::min(workers.GetThreadCount(), in_edges.size());
+    std::vector<std::vector<HierarchyEdge>> thread_shortcuts(thread_count);
+    auto find_shortcuts = [&](size_t thread_index) {
+        if (thread_index >= thread_count) {
+            return;
+        }
+        const size_t edges_per_thread = in_edges.size() / thread_count;
+        const size_t extra_edges = in_edges.size() % thread_count;
+        const size_t begin = thread_index * edges_per_thread + std::min(thread_index, extra_edges);
+        const size_t end = begin + edges_per_thread + (thread_index < extra_edges ? 1 : 0);
+        for (size_t i = begin; i < end; ++i) {
+            AppendShortcuts(state, witness_spaces[thread_index], vertex, in_edges[i], out_edges, max_out_weight,
+                            thread_shortcuts[thread_index]);
+        }
+    };
+    if (thread_count == 1) {
+        find_shortcuts(0);
+    } else {
+        workers.Run(find_shortcuts);
+    }
+
+    std::vector<HierarchyEdge> shortcuts = std::move(thread_shortcuts.front());
+    for (size_t thread_index = 1; thread_index < thread_count; ++thread_index) {
+        shortcuts.insert(shortcuts.end(), thread_shortcuts[thread_index].begin(), thread_shortcuts[thread_index].end());
+    }
+    return shortcuts;
+}
+
+template <typename Weight>
+int ContractionHierarchies<Weight>::ComputePriority(const ContractionState& state, VertexId vertex,
+                                                    const std::vector<HierarchyEdge>& shortcuts) const {
+    // Разность рёбер плюс число уже стянутых соседей — классическая эвристика,
+    // равномерно распределяющая стягивание по графу
+    int removed_edges = 0;
+    for (const size_t edge_id : state.in_edges[vertex]) {
+        removed_edges += state.contracted[edges_[edge_id].from] ? 0 : 1;
+    }
+    for (const size_t edge_id : state.out_edges[vertex]) {
+        removed_edges += state.contracted[edges_[edge_id].to] ? 0 : 1;
+    }
+    return static_cast<int>(shortcuts.size()) - removed_edges + state.contracted_neighbors[vertex];
+}
+
+template <typename Weight>
+void ContractionHierarchies<Weight>::Contract(size_t thread_count) {
+    ContractionState state{
+        std::vector<std::vector<size_t>>(vertex_count_),
+        std::vector<std::vector<size_t>>(vertex_count_),
+        std::vector<bool>(vertex_count_, false),
+        std::vector<int>(vertex_count_, 0)
+    };
+    WitnessWorkers workers(thread_count);
+    std::vector<WitnessSpace> witness_spaces(workers.GetThreadCount(), WitnessSpace(vertex_count_));
+    for (size_t edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+        if (edges_[edge_id].from != edges_[edge_id].to) {
+            state.out_edges[edges_[edge_id].from].push_back(edge_id);
+            state.in_edges[edges_[edge_id].to].push_back(edge_id);
+        }
+    }
+
+    using PriorityItem = std::pair<int, VertexId>;
+    std::priority_queue<PriorityItem, std::vector<PriorityItem>, std::greater<PriorityItem>> queue;
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        queue.push({ComputePriority(state, vertex, FindShortcuts(state, witness_spaces, workers, vertex)), vertex});
+    }
+
+    size_t rank = 0;
+    while (!queue.empty()) {
+        const VertexId vertex = queue.top().second;
+        queue.pop();
+
+        // Ленивое обновление: приоритет пересчитывается при извлечении,
+        // и вершина откладывается, если перестала быть наименее важной
+        std::vector<HierarchyEdge> shortcuts = FindShortcuts(state, witness_spaces, workers, vertex);
+        const int priority = ComputePriority(state, vertex, shortcuts);
+        if (!queue.empty() && priority > queue.top().first) {
+            queue.push({priority, vertex});
+            continue;
+        }
+
+        for (HierarchyEdge& shortcut : shortcuts) {
+            state.out_edges[shortcut.from].push_back(edges_.size());
+            state.in_edges[shortcut.to].push_back(edges_.size());
+            edges_.push_back(std::move(shortcut));
+        }
+        // Рёбра стянутой вершины убираются из списков соседей, чтобы поиск свидетелей
+        // не просматривал их снова и снова
+        auto erase_edge = [](std::vector<size_t>& edge_ids, size_t edge_id) {
+            edge_ids.erase(std::remove(edge_ids.begin(), edge_ids.end(), edge_id), edge_ids.end());
+        };
+        for (const size_t edge_id : state.in_edges[vertex]) {
+            ++state.contracted_neighbors[edges_[edge_id].from];
+            erase_edge(state.out_edges[edges_[edge_id].from], edge_id);
+        }
+        for (const size_t edge_id : state.out_edges[vertex]) {
+            ++state.contracted_neighbors[edges_[edge_id].to];
+            erase_edge(state.in_edges[edges_[edge_id].to], edge_id);
+        }
+        state.in_edges[vertex].clear();
+        state.out_edges[vertex].clear();
+        state.contracted[vertex] = true;
+        ranks_[vertex] = rank++;
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchies<Weight>::BuildSearchGraphs() {
+    forward_offsets_.assign(vertex_count_ + 1, 0);
+    backward_offsets_.assign(vertex_count_ + 1, 0);
+    for (const HierarchyEdge& edge : edges_) {
+        if (edge.from == edge.to) {
+            continue;
+        }
+        if (ranks_[edge.from] < ranks_[edge.to]) {
+            ++forward_offsets_[edge.from + 1];
+        } else {
+            ++backward_offsets_[edge.to + 1];
+        }
+    }
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        forward_offsets_[vertex + 1] += forward_offsets_[vertex];
+        backward_offsets_[vertex + 1] += backward_offsets_[vertex];
+    }
+
+    forward_edges_.resize(forward_offsets_.back());
+    backward_edges_.resize(backward_offsets_.back());
+    std::vector<size_t> forward_positions(forward_offsets_.begin(), forward_offsets_.end() - 1);
+    std::vector<size_t> backward_positions(backward_offsets_.begin(), backward_offsets_.end() - 1);
+    for (size_t edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+        const HierarchyEdge& edge = edges_[edge_id];
+        if (edge.from == edge.to) {
+            continue;
+        }
+        if (ranks_[edge.from] < ranks_[edge.to]) {
+            forward_edges_[forward_positions[edge.from]++] = SearchEdge{edge.to, edge.weight, edge_id};
+        } else {
+            backward_edges_[backward_positions[edge.to]++] = SearchEdge{edge.from, edge.weight, edge_id};
+        }
+    }
+}
+
+template <typename Weight>
+std::vector<std::pair<VertexId, Weight>> ContractionHierarchies<Weight>::SearchUpward(
+    VertexId start, bool is_forward, SearchSpace& space
+) const {
+    const std::vector<size_t>& offsets = is_forward ? forward_offsets_ : backward_offsets_;
+    const std::vector<SearchEdge>& search_edges = is_forward ? forward_edges_ : backward_edges_;
+    std::vector<std::pair<VertexId, Weight>> settled;
+
+    Queue queue;
+    space.Prepare(vertex_count_);
+    space.SetWeight(start, ZERO_WEIGHT);
+    queue.push({ZERO_WEIGHT, start});
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (*space.weights[vertex] < weight) {
+            continue;
+        }
+        settled.push_back({vertex, weight});
+        for (size_t position = offsets[vertex]; position < offsets[vertex + 1]; ++position) {
+            const SearchEdge& edge = search_edges[position];
+            const Weight candidate_weight = weight + edge.weight;
+            const std::optional<Weight>& target_weight = space.weights[edge.to];
+            if (!target_weight || candidate_weight < *target_weight) {
+                space.SetWeight(edge.to, candidate_weight);
+                queue.push({candidate_weight, edge.to});
+            }
+        }
+    }
+    return settled;
+}
+
+template <typename Weight>
+std::vector<std::vector<std::optional<Weight>>> ContractionHierarchies<Weight>::FindWeights(
+    const std::vector<VertexId>& sources, const std::vector<VertexId>& targets
+) const {
+    for (const VertexId vertex : sources) {
+        if (vertex >= vertex_count_) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+    }
+
+    // Корзины хранятся в CSR-виде: записи (номер цели, вес) сгруппированы по вершинам
+    struct BucketEntry {
+        VertexId vertex;
+        size_t target_index;
+        Weight weight;
+    };
+    SearchSpace space;
+    std::vector<BucketEntry> entries;
+    for (size_t target_index = 0; target_index < targets.size(); ++target_index) {
+        if (targets[target_index] >= vertex_count_) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        for (const auto& [vertex, weight] : SearchUpward(targets[target_index], false, space)) {
+            entries.push_back({vertex, target_index, weight});
+        }
+    }
+    std::vector<size_t> bucket_offsets(vertex_count_ + 1, 0);
+    for (const BucketEntry& entry : entries) {
+        ++bucket_offsets[entry.vertex + 1];
+    }
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        bucket_offsets[vertex + 1] += bucket_offsets[vertex];
+    }
+    std::vector<std::pair<size_t, Weight>> buckets(entries.size());
+    std::vector<size_t> bucket_positions(bucket_offsets.begin(), bucket_offsets.end() - 1);
+    for (const BucketEntry& entry : entries) {
+        buckets[bucket_positions[entry.vertex]++] = {entry.target_index, entry.weight};
+    }
+
+    std::vector<std::vector<std::optional<Weight>>> weights(sources.size(),
+                                                            std::vector<std::optional<Weight>>(targets.size()));
+    for (size_t source_index = 0; source_index < sources.size(); ++source_index) {
+        std::vector<std::optional<Weight>>& weights_from = weights[source_index];
+        for (const auto& [vertex, weight] : SearchUpward(sources[source_index], true, space)) {
+            for (size_t position = bucket_offsets[vertex]; position < bucket_offsets[vertex + 1]; ++position) {
+                const auto& [target_index, target_weight] = buckets[position];
+                const Weight candidate_weight = weight + target_weight;
+                if (!weights_from[target_index] || candidate_weight < *weights_from[target_index]) {
+                    weights_from[target_index] = candidate_weight;
+                }
+            }
+        }
+    }
+    return weights;
+}
+
+template <typename Weight>
+void ContractionHierarchies<Weight>::AppendUnpackedEdges(size_t hierarchy_edge, std::vector<EdgeId>& edges) const {
+    std::vector<size_t> stack{hierarchy_edge};
+    while (!stack.empty()) {
+        const HierarchyEdge& edge = edges_[stack.back()];
+        stack.pop_back();
+        if (edge.original_edge != NO_EDGE) {
+            edges.push_back(edge.original_edge);
+        } else {
+            stack.push_back(edge.second_half);
+            stack.push_back(edge.first_half);
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchies<Weight>::Path>
+ContractionHierarchies<Weight>::FindPath(VertexId from, VertexId to) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (from == to) {
+        return Path{ZERO_WEIGHT, {}};
+    }
+
+    // Запросы идут из нескольких потоков, поэтому пространства поиска у каждого потока свои.
+    // Они живут между запросами, и запрос затрагивает только достигнутые поиском вершины
+    static thread_local SearchSpace forward;
+    static thread_local SearchSpace backward;
+    forward.Prepare(vertex_count_);
+    backward.Prepare(vertex_count_);
+    Queue forward_queue;
+    Queue backward_queue;
+    forward.SetWeight(from, ZERO_WEIGHT);
+    forward_queue.push({ZERO_WEIGHT, from});
+    backward.SetWeight(to, ZERO_WEIGHT);
+    backward_queue.push({ZERO_WEIGHT, to});
+
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+    while (!forward_queue.empty() || !backward_queue.empty()) {
+        // Продвигаем направление с меньшим расстоянием до вершины в начале очереди
+        const bool is_forward = backward_queue.empty()
+            || (!forward_queue.empty() && forward_queue.top().first < backward_queue.top().first);
+        Queue& queue = is_forward ? forward_queue : backward_queue;
+        SearchSpace& space = is_forward ? forward : backward;
+        const SearchSpace& opposite_space = is_forward ? backward : forward;
+
+        const auto [weight, vertex] = queue.top();
+        if (best_weight && !(weight < *best_weight)) {
+            break; // Оба направления уже не могут улучшить найденный путь
+        }
+        queue.pop();
+        if (*space.weights[vertex] < weight) {
+            continue;
+        }
+        if (const auto& opposite_weight = opposite_space.weights[vertex]) {
+            const Weight candidate_weight = weight + *opposite_weight;
+            if (!best_weight || candidate_weight < *best_weight) {
+                best_weight = candidate_weight;
+                meeting_vertex = vertex;
+            }
+        }
+
+        const std::vector<size_t>& offsets = is_forward ? forward_offsets_ : backward_offsets_;
+        const std::vector<SearchEdge>& search_edges = is_forward ? forward_edges_ : backward_edges_;
+        for (size_t position = offsets[vertex]; position < offsets[vertex + 1]; ++position) {
+            const SearchEdge& edge = search_edges[position];
+            const Weight candidate_weight = weight + edge.weight;
+            const auto& weight_to = space.weights[edge.to];
+            if (!weight_to || candidate_weight < *weight_to) {
+                space.SetWeight(edge.to, candidate_weight);
+                space.parent_edges[edge.to] = edge.hierarchy_edge;
+                queue.push({candidate_weight, edge.to});
+            }
+        }
+    }
+
+    if (!best_weight) {
+        return std::nullopt;
+    }
+
+    std::vector<size_t> hierarchy_path;
+    for (VertexId vertex = meeting_vertex; vertex != from; vertex = edges_[forward.parent_edges[vertex]].from) {
+        hierarchy_path.push_back(forward.parent_edges[vertex]);
+    }
+    std::reverse(hierarchy_path.begin(), hierarchy_path.end());
+    for (VertexId vertex = meeting_vertex; vertex != to; vertex = edges_[backward.parent_edges[vertex]].to) {
+        hierarchy_path.push_back(backward.parent_edges[vertex]);
+    }
+
+    std::vector<EdgeId> edges;
+    for (const size_t hierarchy_edge : hierarchy_path) {
+        AppendUnpackedEdges(hierarchy_edge, edges);
+    }
+    return Path{*best_weight, std::move(edges)};
+}
+
+}  // namespace graph
@@ -14,20 +14,29 @@
 
 #include "geo.h"
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace transport {
 
+// Плотные номера остановок и автобусов в порядке добавления в справочник: 0, 1, 2, ...
+using StopId = uint32_t;
+using BusId = uint32_t;
+
+// Названия хранятся в справочнике, который при добавлении заменяет их ссылками на свою копию
 struct Stop {
-	std::string stop_name;
+	std::string_view stop_name;
 	geo::Coordinates coordinates;
+	StopId id = 0; // Назначается справочником
 };
 
 struct Bus {
-	std::string bus_name;
+	std::string_view bus_name;
 	std::vector<const Stop*> stops;
 	bool is_roundtrip;
+	BusId id = 0; // Назначается справочником
 };
 
 struct BusInfo {
@@ -37,6 +46,12 @@ struct BusInfo {
 	double curvature;
 };
 
+// Остановка около точки на карте
+struct NearbyStop {
+	const Stop* stop;
+	double distance; // Расстояние по поверхности Земли в метрах
+};
+
 struct BusComparator {
 	bool operator()(const Bus* lhs, const Bus* rhs) const {
 		return lhs->bus_name < rhs->bus_name;
@@ -1,10 +1,28 @@
 #define _USE_MATH_DEFINES
 #include "geo.h"
 
+#include <cassert>
 #include <cmath>
 
 namespace geo {
 
+namespace {
+
+constexpr double DEG_TO_RAD = M_PI / 180.0;
+
+// Расстояние по заранее вычисленным синусу и косинусу широты. Порядок операций тот же,
+// что в ComputeDistance, поэтому результат совпадает с ним до бита
+double ComputePreparedDistance(const PreparedCoordinates& from, const PreparedCoordinates& to) {
+    if (from.coordinates == to.coordinates) {
+        return 0;
+    }
+    return std::acos(from.sin_lat * to.sin_lat
+                     + from.cos_lat * to.cos_lat * std::cos(std::abs(from.coordinates.lng - to.coordinates.lng) * DEG_TO_RAD))
+        * EARTH_RADIUS;
+}
+
+} // namespace
+
 double ComputeDistance(Coordinates from, Coordinates to) {
     using namespace std;
     if (from == to) {
@@ -13,7 +31,37 @@ double ComputeDistance(Coordinates from, Coordinates to) {
     const double dr = M_PI / 180.0;
     return acos(sin(from.lat * dr) * sin(to.lat * dr)
                 + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
-        * 6371000;
+        * EARTH_RADIUS;
+}
+
+PreparedCoordinates PrepareCoordinates(Coordinates coordinates) {
+    return {coordinates, std::sin(coordinates.lat * DEG_TO_RAD), std::cos(coordinates.lat * DEG_TO_RAD)};
+}
+
+double ComputeDistance(const PreparedCoordinates& from, const PreparedCoordinates& to) {
+    return ComputePreparedDistance(from, to);
+}
+
+void ComputeDistances(
+    const PreparedCoordinates& from,
+    std::span<const PreparedCoordinates> to,
+    std::span<double> distances
+) {
+    assert(distances.size() == to.size());
+    for (size_t i = 0; i < to.size(); ++i) {
+        distances[i] = ComputePreparedDistance(from, to[i]);
+    }
+}
+
+void ComputeDistances(
+    std::span<const PreparedCoordinates> from,
+    std::span<const PreparedCoordinates> to,
+    std::span<double> distances
+) {
+    assert(from.size() == to.size() && distances.size() == to.size());
+    for (size_t i = 0; i < to.size(); ++i) {
+        distances[i] = ComputePreparedDistance(from[i], to[i]);
+    }
 }
 
 }  // namespace geo
\ No newline at end of file
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <cmath>
+#include <span>
 
 namespace geo {
 
+inline constexpr double EARTH_RADIUS = 6371000; // Средний радиус Земли в метрах
+
 struct Coordinates {
     double lat;
     double lng;
@@ -17,4 +20,32 @@ struct Coordinates {
 
 double ComputeDistance(Coordinates from, Coordinates to);
 
+// Точка с заранее вычисленными синусом и косинусом широты (кэш тригонометрии широты).
+// На расстояние остаются два вызова (косинус разности долгот и арккосинус) вместо шести
+struct PreparedCoordinates {
+    Coordinates coordinates;
+    double sin_lat;
+    double cos_lat;
+};
+
+PreparedCoordinates PrepareCoordinates(Coordinates coordinates);
+
+// Результат совпадает с ComputeDistance для исходных координат до бита
+double ComputeDistance(const PreparedCoordinates& from, const PreparedCoordinates& to);
+
+// Расстояния от from до каждой точки to: distances[i] — расстояние до to[i].
+// Обычный цикл по ComputeDistance для подготовленных точек, выигрыш даёт только кэш широты
+void ComputeDistances(
+    const PreparedCoordinates& from,
+    std::span<const PreparedCoordinates> to,
+    std::span<double> distances
+);
+
+// Попарные расстояния: distances[i] — расстояние от from[i] до to[i]
+void ComputeDistances(
+    std::span<const PreparedCoordinates> from,
+    std::span<const PreparedCoordinates> to,
+    std::span<double> distances
+);
+
 }
\ No newline at end of file
@@ -39,6 +39,53 @@ private:
     std::vector<IncidenceList> incidence_lists_;
 };
 
+/*
+ * Неизменяемое представление графа в формате CSR (compressed sparse row).
+ * Исходящие рёбра вершины vertex занимают в плотных массивах позиции
+ * [GetEdgesBegin(vertex), GetEdgesEnd(vertex)), поэтому цикл релаксации читает
+ * память последовательно, без обращений к отдельным спискам смежности.
+ * GetEdgeId переводит позицию в идентификатор ребра исходного графа, а GetIncidentEdges, как
+ * у DirectedWeightedGraph, перечисляет идентификаторы исходящих рёбер вершины. GetEdge нет:
+ * поиск ребра по идентификатору потребовал бы ещё двух массивов, а в исходном графе он стоит O(1)
+ */
+template <typename Weight>
+class FrozenDirectedWeightedGraph {
+private:
+    using IncidentEdgesRange = ranges::Range<std::vector<EdgeId>::const_iterator>;
+
+public:
+    FrozenDirectedWeightedGraph() = default;
+    explicit FrozenDirectedWeightedGraph(const DirectedWeightedGraph<Weight>& graph);
+
+    size_t GetVertexCount() const;
+    size_t GetEdgeCount() const;
+
+    size_t GetEdgesBegin(VertexId vertex) const {
+        return offsets_[vertex];
+    }
+    size_t GetEdgesEnd(VertexId vertex) const {
+        return offsets_[vertex + 1];
+    }
+    VertexId GetTarget(size_t position) const {
+        return targets_[position];
+    }
+    Weight GetWeight(size_t position) const {
+        return weights_[position];
+    }
+    EdgeId GetEdgeId(size_t position) const {
+        return edge_ids_[position];
+    }
+    IncidentEdgesRange GetIncidentEdges(VertexId vertex) const {
+        return {edge_ids_.begin() + offsets_[vertex], edge_ids_.begin() + offsets_[vertex + 1]};
+    }
+
+private:
+    std::vector<size_t> offsets_{0};
+    std::vector<VertexId> targets_;
+    std::vector<Weight> weights_;
+    std::vector<EdgeId> edge_ids_;   // Позиция в плотных массивах -> EdgeId
+};
+
 template <typename Weight>
 DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
     : incidence_lists_(vertex_count) {
@@ -72,4 +119,35 @@ typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
     return ranges::AsRange(incidence_lists_.at(vertex));
 }
-}  // namespace graph
\ No newline at end of file
+
+template <typename Weight>
+FrozenDirectedWeightedGraph<Weight>::FrozenDirectedWeightedGraph(const DirectedWeightedGraph<Weight>& graph) {
+    const size_t vertex_count = graph.GetVertexCount();
+    const size_t edge_count = graph.GetEdgeCount();
+    offsets_.reserve(vertex_count + 1);
+    targets_.reserve(edge_count);
+    weights_.reserve(edge_count);
+    edge_ids_.reserve(edge_count);
+
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            const Edge<Weight>& edge = graph.GetEdge(edge_id);
+            targets_.push_back(edge.to);
+            weights_.push_back(edge.weight);
+            edge_ids_.push_back(edge_id);
+        }
+        offsets_.push_back(targets_.size());
+    }
+}
+
+template <typename Weight>
+size_t FrozenDirectedWeightedGraph<Weight>::GetVertexCount() const {
+    return offsets_.size() - 1;
+}
+
+template <typename Weight>
+size_t FrozenDirectedWeightedGraph<Weight>::GetEdgeCount() const {
+    return targets_.size();
+}
+
+}  // namespace graph
@@ -1,226 +1,357 @@
 #include "json.h"
 
-#include <iterator>
+#include <cctype>
+#include <charconv>
+#include <cstring>
 
 namespace json {
 
 namespace {
 using namespace std::literals;
 
-Node LoadNode(std::istream& input);
-Node LoadString(std::istream& input);
+// Разбор текста, который просматривается указателем. Текст либо целиком лежит в памяти,
+// либо читается из потока блоками по BUFFER_SIZE байт, поэтому в памяти не бывает всего файла.
+// Обычные символы строк добавляются в Node кусками, а не по одному
+class Parser {
+public:
+    explicit Parser(std::string_view input)
+    : position_(input.data()), end_(input.data() + input.size())
+    {
 
-std::string LoadLiteral(std::istream& input) {
-    std::string s;
-    while (std::isalpha(input.peek())) {
-        s.push_back(static_cast<char>(input.get()));
     }
-    return s;
-}
 
-Node LoadArray(std::istream& input) {
-    std::vector<Node> result;
+    explicit Parser(std::istream& input)
+    : input_(&input), buffer_(BUFFER_SIZE)
+    {
+
+    }
 
-    for (char c; input >> c && c != ']';) {
-        if (c != ',') {
-            input.putback(c);
+    Node LoadNode() {
+        char c;
+        if (!NextChar(c)) {
+            throw ParsingError("Unexpected EOF"s);
+        }
+        switch (c) {
+            case '[':
+                return LoadArray();
+            case '{':
+                return LoadDict(nullptr);
+            case '"':
+                return Node(LoadString());
+            case 't':
+                // Атрибут [[fallthrough]] (провалиться) ничего не делает, и является
+                // подсказкой компилятору и человеку, что здесь программист явно задумывал
+                // разрешить переход к инструкции следующей ветки case, а не случайно забыл
+                // написать break, return или throw.
+                // В данном случае, встретив t или f, переходим к попытке парсинга
+                // литералов true либо false
+                [[fallthrough]];
+            case 'f':
+                --position_;
+                return LoadBool();
+            case 'n':
+                --position_;
+                return LoadNull();
+            default:
+                --position_;
+                return LoadNumber();
         }
-        result.push_back(LoadNode(input));
     }
-    if (!input) {
-        throw ParsingError("Array parsing error"s);
+
+    // Как LoadNode, но элементы массивов верхнего словаря, выбранных handler, передаются ему
+    Node LoadRoot(StreamHandler& handler) {
+        char c;
+        if (!NextChar(c)) {
+            throw ParsingError("Unexpected EOF"s);
+        }
+        if (c == '{') {
+            return LoadDict(&handler);
+        }
+        --position_;
+        return LoadNode();
     }
-    return Node(std::move(result));
-}
 
-Node LoadDict(std::istream& input) {
-    Dict dict;
+private:
+    static constexpr size_t BUFFER_SIZE = 1 << 16;
 
-    for (char c; input >> c && c != '}';) {
-        if (c == '"') {
-            std::string key = LoadString(input).AsString();
-            if (input >> c && c == ':') {
-                if (dict.find(key) != dict.end()) {
-                    throw ParsingError("Duplicate key '"s + key + "' have been found");
-                }
-                dict.emplace(std::move(key), LoadNode(input));
-            } else {
-                throw ParsingError(": is expected but '"s + c + "' has been found"s);
-            }
-        } else if (c != ',') {
-            throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
-        }
+    const char* position_ = nullptr;
+    const char* end_ = nullptr;
+    std::istream* input_ = nullptr;
+    std::vector<char> buffer_;
+    // Начало разбираемого числа или литерала. При чтении следующего блока они переносятся в начало буфера
+    const char* token_begin_ = nullptr;
+
+    static bool IsSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
     }
-    if (!input) {
-        throw ParsingError("Dictionary parsing error"s);
+
+    static bool IsStringSpecial(char c) {
+        return c == '"' || c == '\\' || c == '\n' || c == '\r';
     }
-    return Node(std::move(dict));
-}
 
-Node LoadString(std::istream& input) {
-    auto it = std::istreambuf_iterator<char>(input);
-    auto end = std::istreambuf_iterator<char>();
-    std::string s;
-    while (true) {
-        if (it == end) {
-            throw ParsingError("String parsing error");
+    // Читает следующий блок потока. Возвращает false, если текст закончился
+    bool Refill() {
+        if (!input_) {
+            return false;
         }
-        const char ch = *it;
-        if (ch == '"') {
-            ++it;
-            break;
-        } else if (ch == '\\') {
-            ++it;
-            if (it == end) {
-                throw ParsingError("String parsing error");
-            }
-            const char escaped_char = *(it);
-            switch (escaped_char) {
-                case 'n':
-                    s.push_back('\n');
-                    break;
-                case 't':
-                    s.push_back('\t');
-                    break;
-                case 'r':
-                    s.push_back('\r');
-                    break;
-                case '"':
-                    s.push_back('"');
-                    break;
-                case '\\':
-                    s.push_back('\\');
-                    break;
-                default:
-                    throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+        size_t kept = 0;
+        if (token_begin_) {
+            kept = end_ - token_begin_;
+            if (kept == buffer_.size()) {
+                // Число или литерал длиннее буфера: он уже лежит с начала буфера
+                buffer_.resize(2 * buffer_.size());
+            } else {
+                std::memmove(buffer_.data(), token_begin_, kept);
             }
-        } else if (ch == '\n' || ch == '\r') {
-            throw ParsingError("Unexpected end of line"s);
-        } else {
-            s.push_back(ch);
+            token_begin_ = buffer_.data();
         }
-        ++it;
+        input_->read(buffer_.data() + kept, buffer_.size() - kept);
+        position_ = buffer_.data() + kept;
+        end_ = position_ + input_->gcount();
+        return position_ < end_;
     }
 
-    return Node(std::move(s));
-}
+    bool HasChar() {
+        return position_ < end_ || Refill();
+    }
 
-Node LoadBool(std::istream& input) {
-    const auto s = LoadLiteral(input);
-    if (s == "true"sv) {
-        return Node{true};
-    } else if (s == "false"sv) {
-        return Node{false};
-    } else {
-        throw ParsingError("Failed to parse '"s + s + "' as bool"s);
+    bool IsDigitNext() {
+        return HasChar() && *position_ >= '0' && *position_ <= '9';
     }
-}
 
-Node LoadNull(std::istream& input) {
-    if (auto literal = LoadLiteral(input); literal == "null"sv) {
-        return Node{nullptr};
-    } else {
-        throw ParsingError("Failed to parse '"s + literal + "' as null"s);
+    // Пропускает пробельные символы и считывает следующий символ, как input >> c
+    bool NextChar(char& c) {
+        while (HasChar() && IsSpace(*position_)) {
+            ++position_;
+        }
+        if (!HasChar()) {
+            return false;
+        }
+        c = *position_++;
+        return true;
     }
-}
 
-Node LoadNumber(std::istream& input) {
-    std::string parsed_num;
+    // Значение токена, начатого в token_begin_. Действительно до следующего чтения из потока
+    std::string_view TakeToken() {
+        const std::string_view token(token_begin_, static_cast<size_t>(position_ - token_begin_));
+        token_begin_ = nullptr;
+        return token;
+    }
 
-    // Считывает в parsed_num очередной символ из input
-    auto read_char = [&parsed_num, &input] {
-        parsed_num += static_cast<char>(input.get());
-        if (!input) {
-            throw ParsingError("Failed to read number from stream"s);
+    std::string_view LoadLiteral() {
+        token_begin_ = position_;
+        while (HasChar() && std::isalpha(static_cast<unsigned char>(*position_))) {
+            ++position_;
         }
-    };
+        return TakeToken();
+    }
 
-    // Считывает одну или более цифр в parsed_num из input
-    auto read_digits = [&input, read_char] {
-        if (!std::isdigit(input.peek())) {
-            throw ParsingError("A digit is expected"s);
+    // Разбирает элементы массива после '[' и передаёт каждый в on_element
+    template <typename ElementHandler>
+    void LoadArrayElements(ElementHandler&& on_element) {
+        char c;
+        bool is_closed = false;
+        while (NextChar(c)) {
+            if (c == ']') {
+                is_closed = true;
+                break;
+            }
+            if (c != ',') {
+                --position_;
+            }
+            on_element(LoadNode());
         }
-        while (std::isdigit(input.peek())) {
-            read_char();
+        if (!is_closed) {
+            throw ParsingError("Array parsing error"s);
         }
-    };
-
-    if (input.peek() == '-') {
-        read_char();
-    }
-    // Парсим целую часть числа
-    if (input.peek() == '0') {
-        read_char();
-        // После 0 в JSON не могут идти другие цифры
-    } else {
-        read_digits();
     }
 
-    bool is_int = true;
-    // Парсим дробную часть числа
-    if (input.peek() == '.') {
-        read_char();
-        read_digits();
-        is_int = false;
+    Node LoadArray() {
+        std::vector<Node> result;
+        LoadArrayElements([&result](Node element) {
+            result.push_back(std::move(element));
+        });
+        return Node(std::move(result));
     }
 
-    // Парсим экспоненциальную часть числа
-    if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-        read_char();
-        if (ch = input.peek(); ch == '+' || ch == '-') {
-            read_char();
+    // Массивы по ключам, выбранным handler, не сохраняются в словарь, а передаются ему по элементам
+    Node LoadDict(StreamHandler* handler) {
+        Dict dict;
+
+        char c;
+        bool is_closed = false;
+        while (NextChar(c)) {
+            if (c == '}') {
+                is_closed = true;
+                break;
+            }
+            if (c == '"') {
+                std::string key = LoadString();
+                if (NextChar(c) && c == ':') {
+                    if (handler && handler->IsStreamed(key)) {
+                        if (!NextChar(c)) {
+                            throw ParsingError("Unexpected EOF"s);
+                        }
+                        if (c == '[') {
+                            LoadArrayElements([handler, &key](Node element) {
+                                handler->OnElement(key, std::move(element));
+                            });
+                            continue;
+                        }
+                        --position_;
+                    }
+                    const auto [it, is_inserted] = dict.try_emplace(std::move(key));
+                    if (!is_inserted) {
+                        throw ParsingError("Duplicate key '"s + it->first + "' have been found");
+                    }
+                    it->second = LoadNode();
+                } else {
+                    throw ParsingError(": is expected but '"s + c + "' has been found"s);
+                }
+            } else if (c != ',') {
+                throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+            }
         }
-        read_digits();
-        is_int = false;
+        if (!is_closed) {
+            throw ParsingError("Dictionary parsing error"s);
+        }
+        return Node(std::move(dict));
     }
 
-    try {
-        if (is_int) {
-            // Сначала пробуем преобразовать строку в int
-            try {
-                return std::stoi(parsed_num);
-            } catch (...) {
-                // В случае неудачи, например, при переполнении
-                // код ниже попробует преобразовать строку в double
+    // Вызывается после открывающей кавычки
+    std::string LoadString() {
+        std::string s;
+        while (true) {
+            // Обычные символы до кавычки или escape-последовательности добавляются одним куском.
+            // Строка без escape-последовательностей, целиком лежащая в буфере, копируется за один раз
+            const char* run_begin = position_;
+            while (position_ < end_ && !IsStringSpecial(*position_)) {
+                ++position_;
+            }
+            s.append(run_begin, position_);
+            if (!HasChar()) {
+                throw ParsingError("String parsing error");
+            }
+            const char ch = *position_;
+            if (!IsStringSpecial(ch)) {
+                continue;
+            }
+            ++position_;
+            if (ch == '"') {
+                break;
+            } else if (ch == '\\') {
+                if (!HasChar()) {
+                    throw ParsingError("String parsing error");
+                }
+                const char escaped_char = *position_++;
+                switch (escaped_char) {
+                    case 'n':
+                        s.push_back('\n');
+                        break;
+                    case 't':
+                        s.push_back('\t');
+                        break;
+                    case 'r':
+                        s.push_back('\r');
+                        break;
+                    case '"':
+                        s.push_back('"');
+                        break;
+                    case '\\':
+                        s.push_back('\\');
+                        break;
+                    default:
+                        throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+                }
+            } else {
+                throw ParsingError("Unexpected end of line"s);
             }
         }
-        return std::stod(parsed_num);
-    } catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+        return s;
     }
-}
 
-Node LoadNode(std::istream& input) {
-    char c;
-    if (!(input >> c)) {
-        throw ParsingError("Unexpected EOF"s);
+    Node LoadBool() {
+        const std::string_view s = LoadLiteral();
+        if (s == "true"sv) {
+            return Node{true};
+        } else if (s == "false"sv) {
+            return Node{false};
+        } else {
+            throw ParsingError("Failed to parse '"s + std::string(s) + "' as bool"s);
+        }
     }
-    switch (c) {
-        case '[':
-            return LoadArray(input);
-        case '{':
-            return LoadDict(input);
-        case '"':
-            return LoadString(input);
-        case 't':
-            // Атрибут [[fallthrough]] (провалиться) ничего не делает, и является
-            // подсказкой компилятору и человеку, что здесь программист явно задумывал
-            // разрешить переход к инструкции следующей ветки case, а не случайно забыл
-            // написать break, return или throw.
-            // В данном случае, встретив t или f, переходим к попытке парсинга
-            // литералов true либо false
-            [[fallthrough]];
-        case 'f':
-            input.putback(c);
-            return LoadBool(input);
-        case 'n':
-            input.putback(c);
-            return LoadNull(input);
-        default:
-            input.putback(c);
-            return LoadNumber(input);
+
+    Node LoadNull() {
+        if (const std::string_view literal = LoadLiteral(); literal == "null"sv) {
+            return Node{nullptr};
+        } else {
+            throw ParsingError("Failed to parse '"s + std::string(literal) + "' as null"s);
+        }
     }
-}
+
+    Node LoadNumber() {
+        token_begin_ = position_;
+
+        // Пропускает одну или более цифр
+        auto read_digits = [this] {
+            if (!IsDigitNext()) {
+                throw ParsingError("A digit is expected"s);
+            }
+            while (IsDigitNext()) {
+                ++position_;
+            }
+        };
+
+        if (HasChar() && *position_ == '-') {
+            ++position_;
+        }
+        // Парсим целую часть числа
+        if (HasChar() && *position_ == '0') {
+            ++position_;
+            // После 0 в JSON не могут идти другие цифры
+        } else {
+            read_digits();
+        }
+
+        bool is_int = true;
+        // Парсим дробную часть числа
+        if (HasChar() && *position_ == '.') {
+            ++position_;
+            read_digits();
+            is_int = false;
+        }
+
+        // Парсим экспоненциальную часть числа
+        if (HasChar() && (*position_ == 'e' || *position_ == 'E')) {
+            ++position_;
+            if (HasChar() && (*position_ == '+' || *position_ == '-')) {
+                ++position_;
+            }
+            read_digits();
+            is_int = false;
+        }
+
+        const std::string_view number = TakeToken();
+        if (is_int) {
+            // Сначала пробуем преобразовать число в int. При переполнении
+            // код ниже преобразует его в double
+            int value;
+            if (const auto [end, error] = std::from_chars(number.data(), number.data() + number.size(), value);
+                error == std::errc{})
+            {
+                return value;
+            }
+        }
+        // from_chars не принимает ведущий '+', а в остальном разбирает ту же запись, что и stod
+        double value;
+        if (const auto [end, error] = std::from_chars(number.data(), number.data() + number.size(), value);
+            error != std::errc{} || end != number.data() + number.size())
+        {
+            throw ParsingError("Failed to convert "s + std::string(number) + " to number"s);
+        }
+        return value;
+    }
+};
 
 struct PrintContext {
     std::ostream& out;
@@ -343,8 +474,16 @@ void PrintNode(const Node& node, const PrintContext& ctx) {
 
 }  // namespace
 
+Document Load(std::string_view input) {
+    return Document{Parser(input).LoadNode()};
+}
+
 Document Load(std::istream& input) {
-    return Document{LoadNode(input)};
+    return Document{Parser(input).LoadNode()};
+}
+
+Document LoadStreaming(std::istream& input, StreamHandler& handler) {
+    return Document{Parser(input).LoadRoot(handler)};
 }
 
 void Print(const Document& doc, std::ostream& output) {
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <map>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -168,8 +169,27 @@ inline bool operator!=(const Document& lhs, const Document& rhs) {
     return !(lhs == rhs);
 }
 
+// Разбирает первое значение JSON в тексте input. Текст должен жить только во время вызова
+Document Load(std::string_view input);
+// Читает поток блоками, пока не разобрано первое значение JSON
 Document Load(std::istream& input);
 
+// Получатель элементов при потоковом разборе
+class StreamHandler {
+public:
+    // Нужно ли передавать элементы массива по ключу key верхнего словаря вместо сохранения в документ
+    virtual bool IsStreamed(const std::string& key) const = 0;
+    // Вызывается для каждого элемента сразу после его разбора, в порядке массива
+    virtual void OnElement(const std::string& key, Node element) = 0;
+
+protected:
+    ~StreamHandler() = default;
+};
+
+// Как Load(std::istream&), но массивы верхнего словаря, выбранные handler, не попадают в документ:
+// их элементы передаются handler по одному, поэтому в памяти не бывает всего массива
+Document LoadStreaming(std::istream& input, StreamHandler& handler);
+
 void Print(const Document& doc, std::ostream& output);
 
 }  // namespace json
\ No newline at end of file
@@ -1,15 +1,168 @@
 #include "json_builder.h"
 #include "json_reader.h"
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+
 /*
  * Здесь можно разместить код наполнения транспортного справочника данными из JSON,
  * а также код обработки запросов к базе и формирование массива ответов в формате JSON
  */
 
+namespace {
+
+// Добавляет запросы base_requests в справочник по одному, в порядке запросов. Откладываются только
+// ссылки на ещё не добавленные остановки: расстояние записывается, как только появится остановка,
+// а автобус добавляется, как только известны все его остановки. Автобусы за отложенным тоже ждут,
+// поэтому остановки и автобусы получают те же номера, что при разборе всего документа
+class BaseRequestsLoader final : public json::StreamHandler {
+public:
+    explicit BaseRequestsLoader(transport::TransportCatalogue& catalogue)
+    : catalogue_(catalogue)
+    {
+
+    }
+
+    bool IsStreamed(const std::string& key) const override {
+        return key == "base_requests"s;
+    }
+
+    void OnElement(const std::string&, json::Node request) override {
+        AddRequest(request.AsDict());
+    }
+
+    void AddRequest(const json::Dict& request) {
+        const std::string& type = request.at("type"s).AsString();
+        if (type == "Stop"s) {
+            AddStop(request);
+        } else if (type == "Bus"s) {
+            AddBus(request);
+        }
+    }
+
+    // Вызывается после всех запросов: проверяет, что отложенного не осталось, и замораживает справочник
+    void Finish() {
+        if (!pending_distances_.empty()) {
+            throw std::invalid_argument("Unknown stop in base_requests: "s + pending_distances_.begin()->first);
+        }
+        if (!pending_buses_.empty()) {
+            throw std::invalid_argument("Unknown stop in base_requests: "s + pending_buses_.front().unresolved_stops.back().second);
+        }
+        catalogue_.Freeze(std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+private:
+    struct PendingDistance {
+        const transport::Stop* from;
+        int distance;
+    };
+
+    struct PendingBus {
+        std::string name;
+        std::vector<const transport::Stop*> stops; // nullptr — остановка ещё не добавлена
+        std::vector<std::pair<size_t, std::string>> unresolved_stops; // Индекс в stops и название остановки
+        bool is_roundtrip;
+    };
+
+    transport::TransportCatalogue& catalogue_;
+    // Ключ — название остановки, до которой задано расстояние
+    std::unordered_map<std::string, std::vector<PendingDistance>> pending_distances_;
+    std::deque<PendingBus> pending_buses_;
+
+    void AddStop(const json::Dict& stop_dict) {
+        const std::string& stop_name = stop_dict.at("name"s).AsString();
+        catalogue_.AddStop({
+            stop_name,
+            {stop_dict.at("latitude"s).AsDouble(), stop_dict.at("longitude"s).AsDouble()}
+        });
+        const transport::Stop* stop = catalogue_.FindStop(stop_name);
+        if (const auto it = pending_distances_.find(stop_name); it != pending_distances_.end()) {
+            for (const PendingDistance& pending_distance : it->second) {
+                catalogue_.SetDistanceBetweenStops(pending_distance.from, stop, pending_distance.distance);
+            }
+            pending_distances_.erase(it);
+        }
+        for (const auto& [to_name, distance] : stop_dict.at("road_distances"s).AsDict()) {
+            if (const transport::Stop* to = catalogue_.FindStop(to_name)) {
+                catalogue_.SetDistanceBetweenStops(stop, to, distance.AsInt());
+            } else {
+                pending_distances_[to_name].push_back({stop, distance.AsInt()});
+            }
+        }
+        AddPendingBuses();
+    }
+
+    void AddBus(const json::Dict& bus_dict) {
+        PendingBus& bus = pending_buses_.emplace_back();
+        bus.name = bus_dict.at("name"s).AsString();
+        bus.is_roundtrip = bus_dict.at("is_roundtrip"s).AsBool();
+        const json::Array& stops_from_json = bus_dict.at("stops"s).AsArray();
+        bus.stops.reserve(stops_from_json.size());
+        for (const json::Node& stop_name : stops_from_json) {
+            const transport::Stop* stop = catalogue_.FindStop(stop_name.AsString());
+            if (!stop) {
+                bus.unresolved_stops.emplace_back(bus.stops.size(), stop_name.AsString());
+            }
+            bus.stops.push_back(stop);
+        }
+        AddPendingBuses();
+    }
+
+    // Добавляет автобусы из начала очереди, пока у очередного известны все остановки
+    void AddPendingBuses() {
+        while (!pending_buses_.empty()) {
+            PendingBus& bus = pending_buses_.front();
+            while (!bus.unresolved_stops.empty()) {
+                const auto& [index, stop_name] = bus.unresolved_stops.back();
+                const transport::Stop* stop = catalogue_.FindStop(stop_name);
+                if (!stop) {
+                    return;
+                }
+                bus.stops[index] = stop;
+                bus.unresolved_stops.pop_back();
+            }
+            catalogue_.AddBus({bus.name, std::move(bus.stops), bus.is_roundtrip});
+            pending_buses_.pop_front();
+        }
+    }
+};
+
+json::Document LoadWithBaseRequests(std::istream& input, transport::TransportCatalogue& catalogue) {
+    BaseRequestsLoader loader(catalogue);
+    json::Document document = json::LoadStreaming(input, loader);
+    loader.Finish();
+    return document;
+}
+
+} // namespace
+
+JsonReader::JsonReader(std::istream& request, transport::TransportCatalogue& catalogue)
+: request_(LoadWithBaseRequests(request, catalogue))
+{
+
+}
+
 const json::Array& JsonReader::GetBaseRequests() const {
     return request_.GetRoot().AsDict().at("base_requests"s).AsArray();
 }
 
+bool JsonReader::HasUpdateRequests() const {
+    return GetUpdateRequests() != nullptr;
+}
+
+const json::Array* JsonReader::GetUpdateRequests() const {
+    const json::Dict& root = request_.GetRoot().AsDict();
+    const auto it = root.find("update_requests"s);
+    return it != root.end() ? &it->second.AsArray() : nullptr;
+}
+
 const json::Array& JsonReader::GetStatRequests() const {
     return request_.GetRoot().AsDict().at("stat_requests"s).AsArray();
 }
@@ -22,62 +175,81 @@ const json::Dict& JsonReader::GetRoutingSettings() const {
     return request_.GetRoot().AsDict().at("routing_settings"s).AsDict();
 }
 
-void JsonReader::AddStop(const json::Dict& stop_dict, transport::TransportCatalogue& catalogue) {
-    catalogue.AddStop({
-        stop_dict.at("name"s).AsString(),
-        {stop_dict.at("latitude"s).AsDouble(), stop_dict.at("longitude"s).AsDouble()}
-    });
+const json::Dict& JsonReader::GetSerializationSettings() const {
+    return request_.GetRoot().AsDict().at("serialization_settings"s).AsDict();
 }
 
-void JsonReader::SetDistancesBetweenStops(const json::Dict& stop_dict, transport::TransportCatalogue& catalogue) {
-    const transport::Stop* base_stop = catalogue.FindStop(stop_dict.at("name"s).AsString());
-    const json::Dict& names_and_distances_dict = stop_dict.at("road_distances"s).AsDict();
-    for (const auto& [stop_name, distance] : names_and_distances_dict) {
-        catalogue.SetDistanceBetweenStops(
-            base_stop,
-            catalogue.FindStop(stop_name),
-            distance.AsInt()
-        );
+void JsonReader::ApplyBaseRequests(transport::TransportCatalogue& catalogue) {
+    BaseRequestsLoader loader(catalogue);
+    for (const json::Node& request : GetBaseRequests()) {
+        loader.AddRequest(request.AsDict());
     }
+    loader.Finish();
 }
 
-std::vector<std::string_view> JsonReader::ParseBusStops(const json::Array& bus_stops_array) {
-    std::vector<std::string_view> bus_stop_names;
-    for (const json::Node& stop_as_node : bus_stops_array) {
-        bus_stop_names.push_back(stop_as_node.AsString());
+const transport::Stop* JsonReader::FindStopToUpdate(
+    const transport::TransportCatalogue& catalogue,
+    const std::string& stop_name
+) const {
+    const transport::Stop* stop = catalogue.FindStop(stop_name);
+    if (!stop) {
+        throw std::invalid_argument("Unknown stop in update_requests: "s + stop_name);
     }
-    return bus_stop_names;
+    return stop;
 }
 
-void JsonReader::AddBus(const json::Dict& bus_dict, transport::TransportCatalogue& catalogue) {
-    std::vector<const transport::Stop*> bus_stops;
-    const json::Array& stops_from_json = bus_dict.at("stops"s).AsArray();
-    for (const std::string_view& stop_name : ParseBusStops(stops_from_json)) {
-        bus_stops.push_back(catalogue.FindStop(stop_name));
+void JsonReader::ApplyUpdateRequests(transport::TransportCatalogue& catalogue) {
+    const json::Array* update_requests = GetUpdateRequests();
+    if (!update_requests) {
+        return;
     }
-    catalogue.AddBus({bus_dict.at("name"s).AsString(), bus_stops, bus_dict.at("is_roundtrip"s).AsBool()});
-}
-
-void JsonReader::ApplyBaseRequests(transport::TransportCatalogue& catalogue) {
-    const json::Array& base_requests = GetBaseRequests();
-    for (const json::Node& request : base_requests) {
+    for (const json::Node& request : *update_requests) {
         const json::Dict& cur_dict = request.AsDict();
         if (cur_dict.at("type"s).AsString() == "Stop"s) {
-            AddStop(cur_dict, catalogue);
+            catalogue.UpdateStop({
+                cur_dict.at("name"s).AsString(),
+                {cur_dict.at("latitude"s).AsDouble(), cur_dict.at("longitude"s).AsDouble()}
+            });
         }
     }
-    for (const json::Node& request : base_requests) {
+    for (const json::Node& request : *update_requests) {
         const json::Dict& cur_dict = request.AsDict();
-        if (cur_dict.at("type"s).AsString() == "Stop"s) {
-            SetDistancesBetweenStops(cur_dict, catalogue);
+        const std::string& type = cur_dict.at("type"s).AsString();
+        if (type == "Stop"s) {
+            if (const auto it = cur_dict.find("road_distances"s); it != cur_dict.end()) {
+                const transport::Stop* base_stop = FindStopToUpdate(catalogue, cur_dict.at("name"s).AsString());
+                for (const auto& [stop_name, distance] : it->second.AsDict()) {
+                    catalogue.SetDistanceBetweenStops(base_stop, FindStopToUpdate(catalogue, stop_name), distance.AsInt());
+                }
+            }
+        } else if (type == "RemoveDistance"s) {
+            catalogue.RemoveDistanceBetweenStops(
+                FindStopToUpdate(catalogue, cur_dict.at("from"s).AsString()),
+                FindStopToUpdate(catalogue, cur_dict.at("to"s).AsString())
+            );
         }
     }
-    for (const json::Node& request : base_requests) {
+    for (const json::Node& request : *update_requests) {
         const json::Dict& cur_dict = request.AsDict();
-        if (cur_dict.at("type"s).AsString() == "Bus"s) {
-            AddBus(cur_dict, catalogue);
+        const std::string& type = cur_dict.at("type"s).AsString();
+        if (type == "Bus"s) {
+            std::vector<const transport::Stop*> bus_stops;
+            for (const json::Node& stop_name : cur_dict.at("stops"s).AsArray()) {
+                bus_stops.push_back(FindStopToUpdate(catalogue, stop_name.AsString()));
+            }
+            catalogue.UpdateBus({cur_dict.at("name"s).AsString(), std::move(bus_stops), cur_dict.at("is_roundtrip"s).AsBool()});
+        } else if (type == "RemoveBus"s) {
+            catalogue.RemoveBus(catalogue.FindBus(cur_dict.at("name"s).AsString()));
         }
     }
+    for (const json::Node& request : *update_requests) {
+        const json::Dict& cur_dict = request.AsDict();
+        if (cur_dict.at("type"s).AsString() == "RemoveStop"s) {
+            catalogue.RemoveStop(catalogue.FindStop(cur_dict.at("name"s).AsString()));
+        }
+    }
+    // Сведения пересчитываются только для изменённых автобусов, у остальных они сохранились
+    catalogue.Freeze(std::max(1u, std::thread::hardware_concurrency()));
 }
 
 const json::Dict JsonReader::PrepareBusAnswer(const transport::TransportCatalogue& catalogue, const json::Dict& cur_dict) const {
@@ -118,9 +290,11 @@ const json::Dict JsonReader::PrepareStopAnswer(const transport::TransportCatalog
             .Build()
         .AsDict();
     } else {
+        const std::span<const transport::Bus* const> stop_buses = catalogue.GetStopToBuses(stop);
         json::Array buses;
-        for (const transport::Bus* bus : catalogue.GetStopToBuses(stop)) {
-            buses.push_back(bus->bus_name);
+        buses.reserve(stop_buses.size());
+        for (const transport::Bus* bus : stop_buses) {
+            buses.push_back(std::string(bus->bus_name));
         }
         stat = json::Builder{}
                 .StartDict()
@@ -148,13 +322,49 @@ const json::Dict JsonReader::PrepareMapAnswer(const RequestHandler& request_hand
     return stat;
 }
 
+json::Array JsonReader::PrepareRouteItems(const transport::TransportRouter::RouteView& route) const {
+    json::Array items;
+    items.reserve(route.GetEdges().size());
+    route.ForEachItem([&items](const transport::TransportRouter::EdgeInfo& edge_info) {
+        if (std::holds_alternative<transport::TransportRouter::WaitEdgeInfo>(edge_info)) {
+            const transport::TransportRouter::WaitEdgeInfo wait_info = std::get<
+                transport::TransportRouter::WaitEdgeInfo
+            >(edge_info);
+            items.emplace_back(
+                json::Builder{}
+                .StartDict()
+                    .Key("type").Value("Wait")
+                    .Key("stop_name").Value(std::string(wait_info.stop->stop_name))
+                    .Key("time").Value(wait_info.bus_wait_time)
+                .EndDict()
+            .Build()
+            );
+        } else {
+            const transport::TransportRouter::BusEdgeInfo bus_info = std::get<
+                transport::TransportRouter::BusEdgeInfo
+            >(edge_info);
+            items.emplace_back(
+                json::Builder{}
+                .StartDict()
+                    .Key("type").Value("Bus")
+                    .Key("bus").Value(std::string(bus_info.bus->bus_name))
+                    .Key("span_count").Value(static_cast<int>(bus_info.span_count))
+                    .Key("time").Value(bus_info.time)
+                .EndDict()
+            .Build()
+            );
+        }
+    });
+    return items;
+}
+
 const json::Dict JsonReader::PrepareRouteAnswer(const RequestHandler& request_handler, const json::Dict& cur_dict) const {
     json::Dict stat;
 
     const std::string_view stop_from_name = cur_dict.at("from"s).AsString();
     const std::string_view stop_to_name = cur_dict.at("to"s).AsString();
     
-    const transport::TransportRouter::CompleteRouteInfo route_info = request_handler.GetOptimalRoute(
+    const std::optional<transport::TransportRouter::RouteView> route_info = request_handler.GetOptimalRoute(
         stop_from_name,
         stop_to_name
     );
@@ -167,42 +377,11 @@ const json::Dict JsonReader::PrepareRouteAnswer(const RequestHandler& request_ha
             .Build()
         .AsDict();
     } else {
-        json::Array items;
-        items.reserve(route_info.value().first.size());
-        for (const transport::TransportRouter::EdgeInfo& edge_info : route_info.value().first) {
-            if (std::holds_alternative<transport::TransportRouter::WaitEdgeInfo>(edge_info)) {
-                const transport::TransportRouter::WaitEdgeInfo wait_info = std::get<
-                    transport::TransportRouter::WaitEdgeInfo
-                >(edge_info);
-                items.emplace_back(
-                    json::Builder{}
-                    .StartDict()
-                        .Key("type").Value("Wait")
-                        .Key("stop_name").Value(wait_info.stop->stop_name)
-                        .Key("time").Value(wait_info.bus_wait_time)
-                    .EndDict()
-                .Build()
-                );
-            } else {
-                const transport::TransportRouter::BusEdgeInfo bus_info = std::get<
-                    transport::TransportRouter::BusEdgeInfo
-                >(edge_info);
-                items.emplace_back(
-                    json::Builder{}
-                    .StartDict()
-                        .Key("type").Value("Bus")
-                        .Key("bus").Value(bus_info.bus->bus_name)
-                        .Key("span_count").Value(static_cast<int>(bus_info.span_count))
-                        .Key("time").Value(bus_info.time)
-                    .EndDict()
-                .Build()
-                );
-            }
-        }
+        json::Array items = PrepareRouteItems(route_info.value());
         stat = json::Builder{}
                 .StartDict()
                     .Key("request_id"s).Value(cur_dict.at("id").AsInt())
-                    .Key("total_time"s).Value(route_info.value().second)
+                    .Key("total_time"s).Value(route_info.value().GetTotalTime())
                     .Key("items"s).Value(items)
                 .EndDict()
             .Build()
@@ -212,22 +391,225 @@ const json::Dict JsonReader::PrepareRouteAnswer(const RequestHandler& request_ha
     return stat;
 }
 
-void JsonReader::ParseStatAndPrepareAnswer(const transport::TransportCatalogue& catalogue, const RequestHandler& request_handler) {
+const json::Dict JsonReader::PrepareRouteFromPointAnswer(const RequestHandler& request_handler, const json::Dict& cur_dict) const {
+    auto parse_point = [](const json::Dict& point_dict) {
+        return geo::Coordinates{point_dict.at("latitude"s).AsDouble(), point_dict.at("longitude"s).AsDouble()};
+    };
+
+    const std::optional<transport::TransportRouter::PointRoute> route_info = request_handler.GetOptimalRouteFromPoint(
+        parse_point(cur_dict.at("from"s).AsDict()),
+        parse_point(cur_dict.at("to"s).AsDict())
+    );
+    if (!route_info.has_value()) {
+        return json::Builder{}
+                .StartDict()
+                    .Key("request_id"s).Value(cur_dict.at("id").AsInt())
+                    .Key("error_message"s).Value("not found"s)
+                .EndDict()
+            .Build()
+        .AsDict();
+    }
+
+    // Маршрут начинается и заканчивается пешком: до первой остановки и от последней
+    auto make_walk_item = [](const transport::Stop* stop, double time) {
+        return json::Builder{}
+            .StartDict()
+                .Key("type").Value("Walk")
+                .Key("stop_name").Value(std::string(stop->stop_name))
+                .Key("time").Value(time)
+            .EndDict()
+        .Build();
+    };
+    json::Array items;
+    items.push_back(make_walk_item(route_info.value().stop_from, route_info.value().walk_time_from));
+    for (json::Node& item : PrepareRouteItems(route_info.value().route)) {
+        items.push_back(std::move(item));
+    }
+    items.push_back(make_walk_item(route_info.value().stop_to, route_info.value().walk_time_to));
+    return json::Builder{}
+            .StartDict()
+                .Key("request_id"s).Value(cur_dict.at("id").AsInt())
+                .Key("total_time"s).Value(route_info.value().GetTotalTime())
+                .Key("items"s).Value(items)
+            .EndDict()
+        .Build()
+    .AsDict();
+}
+
+const json::Dict JsonReader::PrepareMatrixAnswer(const RequestHandler& request_handler, const json::Dict& cur_dict) const {
+    auto parse_stop_names = [](const json::Array& stop_names_array) {
+        std::vector<std::string_view> stop_names;
+        stop_names.reserve(stop_names_array.size());
+        for (const json::Node& stop_name : stop_names_array) {
+            stop_names.push_back(stop_name.AsString());
+        }
+        return stop_names;
+    };
+
+    const std::optional<transport::TransportRouter::RouteTimesMatrix> route_times = request_handler.GetRouteTimes(
+        parse_stop_names(cur_dict.at("from"s).AsArray()),
+        parse_stop_names(cur_dict.at("to"s).AsArray())
+    );
+    if (!route_times.has_value()) {
+        return json::Builder{}
+                .StartDict()
+                    .Key("request_id"s).Value(cur_dict.at("id").AsInt())
+                    .Key("error_message"s).Value("not found"s)
+                .EndDict()
+            .Build()
+        .AsDict();
+    }
+
+    // Строка матрицы соответствует остановке из "from", столбец — остановке из "to".
+    // Если маршрута нет, в ячейке стоит null
+    json::Array total_times;
+    total_times.reserve(route_times.value().size());
+    for (const std::vector<std::optional<double>>& route_times_from : route_times.value()) {
+        json::Array row;
+        row.reserve(route_times_from.size());
+        for (const std::optional<double>& route_time : route_times_from) {
+            row.emplace_back(route_time.has_value() ? json::Node(route_time.value()) : json::Node(nullptr));
+        }
+        total_times.emplace_back(std::move(row));
+    }
+    return json::Builder{}
+            .StartDict()
+                .Key("request_id"s).Value(cur_dict.at("id").AsInt())
+                .Key("total_times"s).Value(total_times)
+            .EndDict()
+        .Build()
+    .AsDict();
+}
+
+const json::Dict JsonReader::PrepareNearestStopsAnswer(const RequestHandler& request_handler, const json::Dict& cur_dict) const {
+    // Без "count" и "radius" ищется одна ближайшая остановка, без "count" — все остановки в радиусе
+    size_t count = 1;
+    double radius = std::numeric_limits<double>::infinity();
+    if (const auto it = cur_dict.find("radius"s); it != cur_dict.end()) {
+        radius = it->second.AsDouble();
+        count = std::numeric_limits<size_t>::max();
+    }
+    if (const auto it = cur_dict.find("count"s); it != cur_dict.end()) {
+        count = static_cast<size_t>(std::max(it->second.AsInt(), 0));
+    }
+
+    const std::vector<transport::NearbyStop> nearest_stops = request_handler.GetNearestStops(
+        {cur_dict.at("latitude"s).AsDouble(), cur_dict.at("longitude"s).AsDouble()},
+        count,
+        radius
+    );
+    json::Array stops;
+    stops.reserve(nearest_stops.size());
+    for (const transport::NearbyStop& nearby_stop : nearest_stops) {
+        stops.emplace_back(
+            json::Builder{}
+            .StartDict()
+                .Key("stop_name"s).Value(std::string(nearby_stop.stop->stop_name))
+                .Key("distance"s).Value(nearby_stop.distance)
+            .EndDict()
+        .Build()
+        );
+    }
+    return json::Builder{}
+            .StartDict()
+                .Key("request_id"s).Value(cur_dict.at("id").AsInt())
+                .Key("stops"s).Value(stops)
+            .EndDict()
+        .Build()
+    .AsDict();
+}
+
+const json::Dict JsonReader::PrepareAnswer(
+    const transport::TransportCatalogue& catalogue,
+    const RequestHandler& request_handler,
+    const json::Dict& cur_dict
+) const {
+    json::Dict cur_stat;
+    if (cur_dict.at("type"s).AsString() == "Bus"s) {
+        cur_stat = PrepareBusAnswer(catalogue, cur_dict);
+    } else if (cur_dict.at("type"s).AsString() == "Stop") {
+        cur_stat = PrepareStopAnswer(catalogue, cur_dict);
+    } else if (cur_dict.at("type"s).AsString() == "Map") {
+        cur_stat = PrepareMapAnswer(request_handler, cur_dict);
+    } else if (cur_dict.at("type"s).AsString() == "Route") {
+        cur_stat = PrepareRouteAnswer(request_handler, cur_dict);
+    } else if (cur_dict.at("type"s).AsString() == "RouteFromPoint") {
+        cur_stat = PrepareRouteFromPointAnswer(request_handler, cur_dict);
+    } else if (cur_dict.at("type"s).AsString() == "Matrix") {
+        cur_stat = PrepareMatrixAnswer(request_handler, cur_dict);
+    } else if (cur_dict.at("type"s).AsString() == "NearestStops") {
+        cur_stat = PrepareNearestStopsAnswer(request_handler, cur_dict);
+    }
+    return cur_stat;
+}
+
+template <typename PrepareAnswers>
+void JsonReader::PrepareAnswersInParallel(PrepareAnswers prepare_answers) {
     const json::Array& stat_requests = GetStatRequests();
-    for (const json::Node& request : stat_requests) {
-        const json::Dict& cur_dict = request.AsDict();
-        json::Dict cur_stat;
-        if (cur_dict.at("type"s).AsString() == "Bus"s) {
-            cur_stat = PrepareBusAnswer(catalogue, cur_dict);
-        } else if (cur_dict.at("type"s).AsString() == "Stop") {
-            cur_stat = PrepareStopAnswer(catalogue, cur_dict);
-        } else if (cur_dict.at("type"s).AsString() == "Map") {
-            cur_stat = PrepareMapAnswer(request_handler, cur_dict);
-        } else if (cur_dict.at("type"s).AsString() == "Route") {
-            cur_stat = PrepareRouteAnswer(request_handler, cur_dict);
+    const size_t thread_count = std::min(ParseStatThreadCount(), stat_requests.size());
+    if (thread_count <= 1) {
+        json::Array answers(stat_requests.size());
+        prepare_answers(0, 0, stat_requests.size(), answers);
+        answer_.insert(answer_.end(), std::make_move_iterator(answers.begin()), std::make_move_iterator(answers.end()));
+        return;
+    }
+
+    // Справочник, визуализатор и маршрутизатор после построения только читаются, поэтому ответы
+    // готовятся независимо. Потоки забирают запросы небольшими порциями: запросы Map и Matrix
+    // намного тяжелее остальных, и равное деление массива заранее давало бы перекос нагрузки
+    static constexpr size_t REQUESTS_CHUNK_SIZE = 16;
+    json::Array answers(stat_requests.size());
+    std::atomic<size_t> next_request = 0;
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto prepare_chunks = [&](size_t thread_index) {
+        try {
+            for (size_t begin = next_request.fetch_add(REQUESTS_CHUNK_SIZE); begin < stat_requests.size();
+                 begin = next_request.fetch_add(REQUESTS_CHUNK_SIZE))
+            {
+                prepare_answers(thread_index, begin, std::min(begin + REQUESTS_CHUNK_SIZE, stat_requests.size()), answers);
+            }
+        } catch (...) {
+            std::lock_guard guard(error_mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            next_request = stat_requests.size();
         }
-        answer_.push_back(cur_stat);
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(thread_count - 1);
+    for (size_t i = 1; i < thread_count; ++i) {
+        workers.emplace_back(prepare_chunks, i);
+    }
+    prepare_chunks(0);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
     }
+    answer_.insert(answer_.end(), std::make_move_iterator(answers.begin()), std::make_move_iterator(answers.end()));
+}
+
+void JsonReader::ParseStatAndPrepareAnswer(const transport::TransportCatalogue& catalogue, const RequestHandler& request_handler) {
+    const json::Array& stat_requests = GetStatRequests();
+    PrepareAnswersInParallel([&](size_t, size_t begin, size_t end, json::Array& answers) {
+        for (size_t i = begin; i < end; ++i) {
+            answers[i] = PrepareAnswer(catalogue, request_handler, stat_requests[i].AsDict());
+        }
+    });
+}
+
+void JsonReader::ParseStatAndPrepareAnswer(const BaseSnapshots& snapshots) {
+    const json::Array& stat_requests = GetStatRequests();
+    PrepareAnswersInParallel([&](size_t thread_index, size_t begin, size_t end, json::Array& answers) {
+        const auto snapshot = snapshots.Read(thread_index);
+        for (size_t i = begin; i < end; ++i) {
+            answers[i] = PrepareAnswer(snapshot->base->catalogue, snapshot->request_handler, stat_requests[i].AsDict());
+        }
+    });
 }
 
 svg::Color JsonReader::ParseColor(const json::Node& color_node) const {
@@ -281,15 +663,86 @@ renderer::RenderSettings JsonReader::ParseRenderSettings() const {
     return render_settings;
 }
 
+graph::RouterMode JsonReader::ParseRouterMode(const std::string& router_mode_name) const {
+    if (router_mode_name == "all_pairs"s) {
+        return graph::RouterMode::ALL_PAIRS;
+    } else if (router_mode_name == "dijkstra"s) {
+        return graph::RouterMode::DIJKSTRA;
+    } else if (router_mode_name == "contraction_hierarchies"s) {
+        return graph::RouterMode::CONTRACTION_HIERARCHIES;
+    } else if (router_mode_name == "all_pairs_blocked"s) {
+        return graph::RouterMode::ALL_PAIRS_BLOCKED;
+    }
+    throw std::invalid_argument("Unknown router mode: "s + router_mode_name);
+}
+
+transport::BusGraphModel JsonReader::ParseBusGraphModel(const std::string& bus_graph_model_name) const {
+    if (bus_graph_model_name == "stop_pairs"s) {
+        return transport::BusGraphModel::STOP_PAIRS;
+    } else if (bus_graph_model_name == "ride_vertices"s) {
+        return transport::BusGraphModel::RIDE_VERTICES;
+    }
+    throw std::invalid_argument("Unknown bus graph model: "s + bus_graph_model_name);
+}
+
 transport::TransportRouteSettings JsonReader::ParseRouteSettings() const {
     const json::Dict& route_settings_dict = GetRoutingSettings();
     transport::TransportRouteSettings route_settings {
         route_settings_dict.at("bus_wait_time").AsInt(),
         route_settings_dict.at("bus_velocity").AsDouble(),
     };
+    if (const auto it = route_settings_dict.find("router_mode"s); it != route_settings_dict.end()) {
+        route_settings.router_mode = ParseRouterMode(it->second.AsString());
+    }
+    if (const auto it = route_settings_dict.find("bus_graph_model"s); it != route_settings_dict.end()) {
+        route_settings.bus_graph_model = ParseBusGraphModel(it->second.AsString());
+    }
+    if (const auto it = route_settings_dict.find("router_threads"s); it != route_settings_dict.end()) {
+        route_settings.router_thread_count = ParseThreadCount(it->second, "router_threads"s);
+    }
+    if (const auto it = route_settings_dict.find("walk_velocity"s); it != route_settings_dict.end()) {
+        route_settings.walk_velocity = it->second.AsDouble();
+        if (route_settings.walk_velocity <= 0) {
+            throw std::invalid_argument("walk_velocity should be positive"s);
+        }
+    }
+    if (const auto it = route_settings_dict.find("walk_stop_count"s); it != route_settings_dict.end()) {
+        if (it->second.AsInt() <= 0) {
+            throw std::invalid_argument("walk_stop_count should be positive"s);
+        }
+        route_settings.walk_stop_count = static_cast<size_t>(it->second.AsInt());
+    }
     return route_settings;
 }
 
+size_t JsonReader::ParseThreadCount(const json::Node& threads_node, const std::string& setting_name) const {
+    // 0 означает «по числу аппаратных потоков»
+    const int threads = threads_node.AsInt();
+    if (threads < 0) {
+        throw std::invalid_argument(setting_name + " should be non-negative"s);
+    }
+    return threads > 0
+        ? static_cast<size_t>(threads)
+        : std::max(1u, std::thread::hardware_concurrency());
+}
+
+size_t JsonReader::ParseStatThreadCount() const {
+    const json::Dict& root = request_.GetRoot().AsDict();
+    const auto settings_it = root.find("stat_settings"s);
+    if (settings_it == root.end()) {
+        return 1;
+    }
+    const json::Dict& stat_settings_dict = settings_it->second.AsDict();
+    if (const auto it = stat_settings_dict.find("threads"s); it != stat_settings_dict.end()) {
+        return ParseThreadCount(it->second, "stat_settings.threads"s);
+    }
+    return 1;
+}
+
+serialization::SerializationSettings JsonReader::ParseSerializationSettings() const {
+    return {GetSerializationSettings().at("file"s).AsString()};
+}
+
 void JsonReader::PrintJSON(std::ostream& output) {
     json::Print(json::Document{answer_}, output);
 }
\ No newline at end of file
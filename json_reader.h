@@ -8,12 +8,32 @@
 #include "json.h"
 #include "map_renderer.h"
 #include "request_handler.h"
+#include "serialization.h"
+#include "snapshot.h"
 #include "transport_catalogue.h"
 
+#include <memory>
 #include <sstream>
 
 using namespace std::literals;
 
+// Версия загруженной базы, которую process_requests публикует через SnapshotStore, вместе с
+// визуализатором и обработчиком запросов. Они ссылаются на base, поэтому база хранится по указателю
+struct BaseSnapshot {
+    explicit BaseSnapshot(std::unique_ptr<serialization::Base> loaded_base)
+    : base(std::move(loaded_base)), map_renderer(base->render_settings),
+      request_handler(base->catalogue, map_renderer, *base->router)
+    {
+
+    }
+
+    std::unique_ptr<serialization::Base> base;
+    renderer::MapRenderer map_renderer;
+    RequestHandler request_handler;
+};
+
+using BaseSnapshots = transport::SnapshotStore<BaseSnapshot>;
+
 class JsonReader {
 public:
     explicit JsonReader(std::istream& request) 
@@ -22,12 +42,32 @@ public:
 
     }
 
+    // Заполняет catalogue запросами base_requests по мере чтения request, не сохраняя раздел в документе,
+    // поэтому в памяти не бывает дерева всех запросов. ApplyBaseRequests после этого не вызывается
+    JsonReader(std::istream& request, transport::TransportCatalogue& catalogue);
+
+    // Заполняет справочник запросами base_requests из документа и замораживает его
     void ApplyBaseRequests(transport::TransportCatalogue& catalogue);
 
+    // Применяет необязательный раздел "update_requests" к уже заполненному справочнику: Stop и Bus
+    // добавляют или изменяют остановку или автобус, RemoveStop, RemoveBus и RemoveDistance удаляют.
+    // Запросы применяются в порядке остановки, расстояния, автобусы, удаление остановок,
+    // поэтому в одном разделе можно перевести автобусы с остановки и затем удалить её
+    void ApplyUpdateRequests(transport::TransportCatalogue& catalogue);
+    bool HasUpdateRequests() const;
+
+    // Отвечает на stat_requests. Если в "stat_settings" задано "threads", запросы делятся между
+    // потоками, а ответы выводятся в исходном порядке
     void ParseStatAndPrepareAnswer(const transport::TransportCatalogue& catalogue, const RequestHandler& request_handler);
+    // То же по опубликованным версиям базы. Поток с номером i читает через слот i, поэтому в snapshots
+    // должно быть не меньше ParseStatThreadCount() слотов. Версия берётся заново на каждую порцию запросов:
+    // версия, опубликованная во время ответа, видна со следующей порции
+    void ParseStatAndPrepareAnswer(const BaseSnapshots& snapshots);
+    size_t ParseStatThreadCount() const;
 
     renderer::RenderSettings ParseRenderSettings() const;
     transport::TransportRouteSettings ParseRouteSettings() const;
+    serialization::SerializationSettings ParseSerializationSettings() const;
 
     void PrintJSON(std::ostream& output);
 
@@ -37,19 +77,33 @@ private:
 
     const json::Array& GetBaseRequests() const;
     const json::Array& GetStatRequests() const;
+    const json::Array* GetUpdateRequests() const;
     const json::Dict& GetRenderSettings() const;
     const json::Dict& GetRoutingSettings() const;
+    const json::Dict& GetSerializationSettings() const;
+    // Готовит ответы на stat_requests в ParseStatThreadCount() потоках. prepare_answers(thread_index, begin, end, answers)
+    // заполняет answers[begin, end) в потоке с номером thread_index
+    template <typename PrepareAnswers>
+    void PrepareAnswersInParallel(PrepareAnswers prepare_answers);
+    size_t ParseThreadCount(const json::Node& threads_node, const std::string& setting_name) const;
 
-    void AddStop(const json::Dict& stop_dict, transport::TransportCatalogue& catalogue);
-    void SetDistancesBetweenStops(const json::Dict& stop_dict, transport::TransportCatalogue& catalogue);
-
-    std::vector<std::string_view> ParseBusStops(const json::Array& bus_stops_array);
-    void AddBus(const json::Dict& bus_dict, transport::TransportCatalogue& catalogue);
+    const transport::Stop* FindStopToUpdate(const transport::TransportCatalogue& catalogue, const std::string& stop_name) const;
 
     svg::Color ParseColor(const json::Node& color_node) const;
+    graph::RouterMode ParseRouterMode(const std::string& router_mode_name) const;
+    transport::BusGraphModel ParseBusGraphModel(const std::string& bus_graph_model_name) const;
 
     const json::Dict PrepareBusAnswer(const transport::TransportCatalogue& catalogue, const json::Dict& cur_dict) const;
     const json::Dict PrepareStopAnswer(const transport::TransportCatalogue& catalogue, const json::Dict& cur_dict) const;
     const json::Dict PrepareMapAnswer(const RequestHandler& request_handler, const json::Dict& cur_dict) const;
+    json::Array PrepareRouteItems(const transport::TransportRouter::RouteView& route) const;
     const json::Dict PrepareRouteAnswer(const RequestHandler& request_handler, const json::Dict& cur_dict) const;
+    const json::Dict PrepareRouteFromPointAnswer(const RequestHandler& request_handler, const json::Dict& cur_dict) const;
+    const json::Dict PrepareMatrixAnswer(const RequestHandler& request_handler, const json::Dict& cur_dict) const;
+    const json::Dict PrepareNearestStopsAnswer(const RequestHandler& request_handler, const json::Dict& cur_dict) const;
+    const json::Dict PrepareAnswer(
+        const transport::TransportCatalogue& catalogue,
+        const RequestHandler& request_handler,
+        const json::Dict& cur_dict
+    ) const;
 };
\ No newline at end of file
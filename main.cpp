@@ -1,17 +1,76 @@
 #include <iostream>
 #include <string>
+#include <string_view>
 
 #include "json_reader.h"
 #include "map_renderer.h"
 #include "request_handler.h"
+#include "serialization.h"
 
 using namespace std;
 using namespace transport;
 
-int main() {
+void PrintUsage(std::ostream& stream = std::cerr) {
+    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+}
+
+// Строит справочник и маршрутизатор и сохраняет их в файл из serialization_settings
+void MakeBase() {
     TransportCatalogue transport_catalogue;
+    JsonReader json_reader(std::cin, transport_catalogue);
+
+    renderer::RenderSettings render_settings = json_reader.ParseRenderSettings();
+    transport::TransportRouteSettings route_setiings = json_reader.ParseRouteSettings();
+    transport::TransportRouter router{route_setiings, transport_catalogue};
+    serialization::SaveBase(
+        json_reader.ParseSerializationSettings().file,
+        transport_catalogue,
+        render_settings,
+        router
+    );
+}
+
+// Загружает сохранённую базу, применяет update_requests и отвечает на stat_requests.
+// Предподсчёт маршрутов при загрузке не повторяется, а update_requests заменяют в графе только рёбра изменённых автобусов.
+// Загруженная база публикуется как версия SnapshotStore. Изменения применяются к её копии, которая затем
+// публикуется новой версией, а потоки ответов читают последнюю версию без блокировок. Здесь публикация
+// заканчивается до начала ответов; чтение во время публикации проверяет tests/snapshot_test.cpp
+void ProcessRequests() {
     JsonReader json_reader(std::cin);
-    json_reader.ApplyBaseRequests(transport_catalogue);
+    BaseSnapshots snapshots(
+        std::make_unique<const BaseSnapshot>(serialization::LoadBase(json_reader.ParseSerializationSettings().file)),
+        json_reader.ParseStatThreadCount()
+    );
+    if (json_reader.HasUpdateRequests()) {
+        std::unique_ptr<serialization::Base> base = serialization::CloneBase(*snapshots.Read(0)->base);
+        json_reader.ApplyUpdateRequests(base->catalogue);
+        base->router->Update(base->catalogue, base->catalogue.TakeChangedBuses());
+        snapshots.Publish(std::make_unique<const BaseSnapshot>(std::move(base)));
+    }
+
+    json_reader.ParseStatAndPrepareAnswer(snapshots);
+    json_reader.PrintJSON(std::cout);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 2) {
+        const std::string_view mode(argv[1]);
+        if (mode == "make_base"sv) {
+            MakeBase();
+        } else if (mode == "process_requests"sv) {
+            ProcessRequests();
+        } else {
+            PrintUsage();
+            return 1;
+        }
+        return 0;
+    } else if (argc != 1) {
+        PrintUsage();
+        return 1;
+    }
+
+    TransportCatalogue transport_catalogue;
+    JsonReader json_reader(std::cin, transport_catalogue);
 
     renderer::RenderSettings render_settings = json_reader.ParseRenderSettings();
     renderer::MapRenderer map_renderer{render_settings};
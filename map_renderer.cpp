@@ -12,7 +12,7 @@ bool IsZero(double value) {
     return std::abs(value) < EPSILON;
 }
 
-std::vector<geo::Coordinates> MapRenderer::GetAllBusesStopsCoordinates(const std::set<const transport::Bus*, transport::BusComparator>& sorted_buses) const {
+std::vector<geo::Coordinates> MapRenderer::GetAllBusesStopsCoordinates(std::span<const transport::Bus* const> sorted_buses) const {
     std::vector<geo::Coordinates> all_buses_stops_coordiantes;
     for (const transport::Bus* bus : sorted_buses) {
         for (const transport::Stop* stop : bus->stops) {
@@ -32,20 +32,8 @@ SphereProjector MapRenderer::MakeSphereProjector(const std::vector<geo::Coordina
     };
 }
 
-std::set<const transport::Stop*, transport::StopComparator> MapRenderer::GetSortedStops(
-    const std::set<const transport::Bus*, transport::BusComparator>& sorted_buses
-) const {
-    std::set<const transport::Stop*, transport::StopComparator> sorted_stops;
-    for (const transport::Bus* bus : sorted_buses) {
-        for (const transport::Stop* stop : bus->stops) {
-            sorted_stops.insert(stop);
-        }
-    }
-    return sorted_stops;
-}
-
 std::vector<svg::Polyline> MapRenderer::GenerateBusesLines(
-    const std::set<const transport::Bus*, transport::BusComparator>& sorted_buses, const SphereProjector& sphere_projector
+    std::span<const transport::Bus* const> sorted_buses, const SphereProjector& sphere_projector
 ) const {
     std::vector<svg::Polyline> buses_lines;
     size_t color_index = 0;
@@ -72,7 +60,7 @@ std::vector<svg::Polyline> MapRenderer::GenerateBusesLines(
 }
 
 std::vector<svg::Text> MapRenderer::GenerateBusesNames(
-    const std::set<const transport::Bus*, transport::BusComparator>& sorted_buses, const SphereProjector& sphere_projector
+    std::span<const transport::Bus* const> sorted_buses, const SphereProjector& sphere_projector
 ) const {
     std::vector<svg::Text> buses_name_and_underlayer;
     size_t color_index = 0;
@@ -86,7 +74,7 @@ std::vector<svg::Text> MapRenderer::GenerateBusesNames(
             SetFontSize(render_settings_.bus_label_font_size).
             SetFontFamily("Verdana"s).
             SetFontWeight("bold"s).
-            SetData(bus->bus_name).
+            SetData(std::string(bus->bus_name)).
             SetFillColor(render_settings_.color_palette.at(color_index % color_palette_size));
 
         cur_bus_underlayer.
@@ -95,7 +83,7 @@ std::vector<svg::Text> MapRenderer::GenerateBusesNames(
             SetFontSize(render_settings_.bus_label_font_size).
             SetFontFamily("Verdana"s).
             SetFontWeight("bold"s).
-            SetData(bus->bus_name).
+            SetData(std::string(bus->bus_name)).
             SetFillColor(render_settings_.underlayer_color).
             SetStrokeColor(render_settings_.underlayer_color).
             SetStrokeWidth(render_settings_.underlayer_width).
@@ -121,7 +109,7 @@ std::vector<svg::Text> MapRenderer::GenerateBusesNames(
 }
 
 std::vector<svg::Circle> MapRenderer::GenerateStopsCircles(
-    const std::set<const transport::Stop*, transport::StopComparator>& sorted_stops, const SphereProjector& sphere_projector
+    std::span<const transport::Stop* const> sorted_stops, const SphereProjector& sphere_projector
 ) const {
     std::vector<svg::Circle> stops_circles;
     for (const transport::Stop* stop : sorted_stops) {
@@ -136,7 +124,7 @@ std::vector<svg::Circle> MapRenderer::GenerateStopsCircles(
 }
 
 std::vector<svg::Text> MapRenderer::GenerateStopsNames(
-    const std::set<const transport::Stop*, transport::StopComparator>& sorted_stops, const SphereProjector& sphere_projector
+    std::span<const transport::Stop* const> sorted_stops, const SphereProjector& sphere_projector
 ) const {
     std::vector<svg::Text> stops_name_and_underlayer;
     for (const transport::Stop* stop : sorted_stops) {
@@ -147,7 +135,7 @@ std::vector<svg::Text> MapRenderer::GenerateStopsNames(
             SetOffset(render_settings_.stop_label_offset).
             SetFontSize(render_settings_.stop_label_font_size).
             SetFontFamily("Verdana"s).
-            SetData(stop->stop_name).
+            SetData(std::string(stop->stop_name)).
             SetFillColor("black"s);
 
         cur_stop_underlayer.
@@ -155,7 +143,7 @@ std::vector<svg::Text> MapRenderer::GenerateStopsNames(
             SetOffset(render_settings_.stop_label_offset).
             SetFontSize(render_settings_.stop_label_font_size).
             SetFontFamily("Verdana"s).
-            SetData(stop->stop_name).
+            SetData(std::string(stop->stop_name)).
             SetFillColor(render_settings_.underlayer_color).
             SetStrokeColor(render_settings_.underlayer_color).
             SetStrokeWidth(render_settings_.underlayer_width).
@@ -168,7 +156,10 @@ std::vector<svg::Text> MapRenderer::GenerateStopsNames(
     return stops_name_and_underlayer;
 }
 
-svg::Document MapRenderer::MakeSVGDocument(const std::set<const transport::Bus*, transport::BusComparator>& sorted_buses) const {
+svg::Document MapRenderer::MakeSVGDocument(
+    std::span<const transport::Bus* const> sorted_buses,
+    std::span<const transport::Stop* const> sorted_stops
+) const {
     svg::Document bus_map;
     const SphereProjector& sphere_projector = MakeSphereProjector(GetAllBusesStopsCoordinates(sorted_buses));
     for (const svg::Polyline& bus_line : GenerateBusesLines(sorted_buses, sphere_projector)) {
@@ -177,7 +168,6 @@ svg::Document MapRenderer::MakeSVGDocument(const std::set<const transport::Bus*,
     for (const svg::Text& bus_name_and_underlayer : GenerateBusesNames(sorted_buses, sphere_projector)) {
         bus_map.Add(bus_name_and_underlayer);
     }
-    const std::set<const transport::Stop*, transport::StopComparator>& sorted_stops = GetSortedStops(sorted_buses);
     for (const svg::Circle& stop_circle : GenerateStopsCircles(sorted_stops, sphere_projector)) {
         bus_map.Add(stop_circle);
     }
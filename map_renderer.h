@@ -14,7 +14,7 @@
 #include <cstdlib>
 #include <iostream>
 #include <optional>
-#include <set>
+#include <span>
 #include <vector>
 
 using namespace std::literals;
@@ -115,20 +115,24 @@ public:
 
     }
 
-    svg::Document MakeSVGDocument(const std::set<const transport::Bus*, transport::BusComparator>& sorted_buses) const;
+    // sorted_buses — автобусы с непустым маршрутом, sorted_stops — остановки, через которые они проходят.
+    // Оба списка упорядочены по названию
+    svg::Document MakeSVGDocument(
+        std::span<const transport::Bus* const> sorted_buses,
+        std::span<const transport::Stop* const> sorted_stops
+    ) const;
 
 private:
     const RenderSettings render_settings_;
 
-    std::vector<geo::Coordinates> GetAllBusesStopsCoordinates(const std::set<const transport::Bus*, transport::BusComparator>& sorted_buses) const;
+    std::vector<geo::Coordinates> GetAllBusesStopsCoordinates(std::span<const transport::Bus* const> sorted_buses) const;
     SphereProjector MakeSphereProjector(const std::vector<geo::Coordinates>& all_buses_stops_coordiantes) const;
 
-    std::vector<svg::Polyline> GenerateBusesLines(const std::set<const transport::Bus*, transport::BusComparator>& sorted_buses, const SphereProjector& sphere_projector) const;
-    std::vector<svg::Text> GenerateBusesNames(const std::set<const transport::Bus*, transport::BusComparator>& sorted_buses, const SphereProjector& sphere_projector) const;
+    std::vector<svg::Polyline> GenerateBusesLines(std::span<const transport::Bus* const> sorted_buses, const SphereProjector& sphere_projector) const;
+    std::vector<svg::Text> GenerateBusesNames(std::span<const transport::Bus* const> sorted_buses, const SphereProjector& sphere_projector) const;
 
-    std::set<const transport::Stop*, transport::StopComparator> GetSortedStops(const std::set<const transport::Bus*, transport::BusComparator>& sorted_buses) const;
-    std::vector<svg::Circle> GenerateStopsCircles(const std::set<const transport::Stop*, transport::StopComparator>& sorted_stops, const SphereProjector& sphere_projector) const;
-    std::vector<svg::Text> GenerateStopsNames(const std::set<const transport::Stop*, transport::StopComparator>& sorted_stops, const SphereProjector& sphere_projector) const;
+    std::vector<svg::Circle> GenerateStopsCircles(std::span<const transport::Stop* const> sorted_stops, const SphereProjector& sphere_projector) const;
+    std::vector<svg::Text> GenerateStopsNames(std::span<const transport::Stop* const> sorted_stops, const SphereProjector& sphere_projector) const;
 
 };
 
@@ -0,0 +1,204 @@
+#include "name_arena.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace transport {
+
+namespace {
+
+// Перемешивание битов из splitmix64: каждый бит результата зависит от всех битов аргумента
+uint64_t Mix(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ULL;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+// В среднем столько названий в корзине. Чем больше, тем меньше массив seed, но дольше построение
+constexpr size_t NAMES_PER_BUCKET = 4;
+// Предел перебора seed для одной корзины. Случайные хэши укладываются в него с большим запасом
+constexpr uint32_t MAX_SEED = 1u << 24;
+
+} // namespace
+
+uint64_t HashName(std::string_view name) {
+    // FNV-1a с перемешиванием в конце
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (const char c : name) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001B3ULL;
+    }
+    return Mix(hash);
+}
+
+bool PerfectNameHash::IsConsistentWith(size_t name_count) const {
+    if (bucket_seeds_.empty() || slot_names_.size() != name_count || slot_fingerprints_.size() != slot_names_.size()) {
+        return false;
+    }
+    return std::all_of(slot_names_.begin(), slot_names_.end(), [name_count](NameId name_id) {
+        return name_id < name_count;
+    });
+}
+
+size_t PerfectNameHash::GetBucket(uint64_t hash) const {
+    return (hash >> 32) % bucket_seeds_.size();
+}
+
+size_t PerfectNameHash::GetSlot(uint64_t hash, uint32_t seed) const {
+    return Mix(hash + seed * 0x9E3779B97F4A7C15ULL) % slot_names_.size();
+}
+
+bool PerfectNameHash::Build(std::span<const uint64_t> hashes) {
+    const size_t size = hashes.size();
+    bucket_seeds_.assign(std::max<size_t>(1, size / NAMES_PER_BUCKET), 0);
+    slot_names_.assign(size, 0);
+    slot_fingerprints_.assign(size, 0);
+
+    std::vector<std::vector<NameId>> buckets(bucket_seeds_.size());
+    for (NameId name_id = 0; name_id < size; ++name_id) {
+        buckets[GetBucket(hashes[name_id])].push_back(name_id);
+    }
+    // Большие корзины размещаются первыми, пока свободных ячеек много
+    std::vector<size_t> bucket_order(buckets.size());
+    std::iota(bucket_order.begin(), bucket_order.end(), 0);
+    std::stable_sort(bucket_order.begin(), bucket_order.end(), [&buckets](size_t lhs, size_t rhs) {
+        return buckets[lhs].size() > buckets[rhs].size();
+    });
+
+    std::vector<bool> is_slot_taken(size, false);
+    std::vector<size_t> bucket_slots;
+    for (const size_t bucket : bucket_order) {
+        if (buckets[bucket].empty()) {
+            break;
+        }
+        uint32_t seed = 0;
+        for (; seed < MAX_SEED; ++seed) {
+            bucket_slots.clear();
+            for (const NameId name_id : buckets[bucket]) {
+                const size_t slot = GetSlot(hashes[name_id], seed);
+                if (is_slot_taken[slot]
+                    || std::find(bucket_slots.begin(), bucket_slots.end(), slot) != bucket_slots.end())
+                {
+                    break;
+                }
+                bucket_slots.push_back(slot);
+            }
+            if (bucket_slots.size() == buckets[bucket].size()) {
+                break;
+            }
+        }
+        if (seed == MAX_SEED) {
+            *this = PerfectNameHash();
+            return false;
+        }
+        bucket_seeds_[bucket] = seed;
+        for (size_t i = 0; i < bucket_slots.size(); ++i) {
+            const NameId name_id = buckets[bucket][i];
+            is_slot_taken[bucket_slots[i]] = true;
+            slot_names_[bucket_slots[i]] = name_id;
+            slot_fingerprints_[bucket_slots[i]] = static_cast<uint32_t>(hashes[name_id]);
+        }
+    }
+    return true;
+}
+
+std::optional<NameId> PerfectNameHash::Find(uint64_t hash) const {
+    if (slot_names_.empty()) {
+        return std::nullopt;
+    }
+    const size_t slot = GetSlot(hash, bucket_seeds_[GetBucket(hash)]);
+    if (slot_fingerprints_[slot] != static_cast<uint32_t>(hash)) {
+        return std::nullopt;
+    }
+    return slot_names_[slot];
+}
+
+NameArena::NameArena(const NameArena& other)
+: blocks_(other.blocks_)
+, names_(other.names_)
+, hashes_(other.hashes_)
+, table_(other.table_)
+, perfect_hash_(other.perfect_hash_)
+{
+    // Свободное место последнего блока остаётся за other, копия начнёт свой блок
+}
+
+NameId NameArena::Intern(std::string_view name) {
+    if (const std::optional<NameId> name_id = Find(name)) {
+        return *name_id;
+    }
+    if (2 * (names_.size() + 1) > table_.size()) {
+        Rehash(std::max<size_t>(16, 2 * table_.size()));
+    }
+    const NameId name_id = static_cast<NameId>(names_.size());
+    const uint64_t hash = HashName(name);
+    names_.push_back(Store(name));
+    hashes_.push_back(hash);
+    const size_t mask = table_.size() - 1;
+    size_t position = hash & mask;
+    while (table_[position] != NO_NAME) {
+        position = (position + 1) & mask;
+    }
+    table_[position] = name_id;
+    return name_id;
+}
+
+std::optional<NameId> NameArena::Find(std::string_view name) const {
+    if (table_.empty()) {
+        return std::nullopt;
+    }
+    const uint64_t hash = HashName(name);
+    if (IsFrozen()) {
+        const std::optional<NameId> name_id = perfect_hash_.Find(hash);
+        if (name_id && names_[*name_id] == name) {
+            return name_id;
+        }
+        return std::nullopt;
+    }
+    const size_t mask = table_.size() - 1;
+    for (size_t position = hash & mask; table_[position] != NO_NAME; position = (position + 1) & mask) {
+        const NameId name_id = table_[position];
+        if (hashes_[name_id] == hash && names_[name_id] == name) {
+            return name_id;
+        }
+    }
+    return std::nullopt;
+}
+
+void NameArena::Freeze() {
+    if (!IsFrozen()) {
+        perfect_hash_.Build(hashes_);
+    }
+}
+
+std::string_view NameArena::Store(std::string_view name) {
+    if (block_used_ + name.size() > block_capacity_) {
+        // Длинное название получает собственный блок
+        block_capacity_ = std::max(BLOCK_SIZE, name.size());
+        blocks_.push_back(std::make_shared<char[]>(block_capacity_));
+        block_used_ = 0;
+    }
+    char* data = blocks_.back().get() + block_used_;
+    if (!name.empty()) {
+        std::memcpy(data, name.data(), name.size());
+    }
+    block_used_ += name.size();
+    return {data, name.size()};
+}
+
+void NameArena::Rehash(size_t table_size) {
+    // Хэши сохранены, поэтому названия заново не хэшируются
+    table_.assign(table_size, NO_NAME);
+    const size_t mask = table_size - 1;
+    for (NameId name_id = 0; name_id < names_.size(); ++name_id) {
+        size_t position = hashes_[name_id] & mask;
+        while (table_[position] != NO_NAME) {
+            position = (position + 1) & mask;
+        }
+        table_[position] = name_id;
+    }
+}
+
+} // namespace transport
\ No newline at end of file
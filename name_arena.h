@@ -0,0 +1,146 @@
+#pragma once
+
+/*
+ * Хранилище названий остановок и автобусов. Каждое название хранится один раз в больших блоках памяти
+ * и получает плотный номер; string_view на названия не меняются, пока жив NameArena.
+ * Хэш названия считается один раз при добавлении, поиск — открытая адресация по сохранённым хэшам,
+ * а после Freeze — минимальная совершенная хэш-функция
+ */
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace transport {
+
+using NameId = uint32_t;
+
+// 64-битный хэш названия. Не зависит от реализации стандартной библиотеки,
+// поэтому построенные на нём таблицы можно сохранять в файл базы
+uint64_t HashName(std::string_view name);
+
+// Минимальная совершенная хэш-функция: n хэшей отображаются в n ячеек без коллизий.
+// Хэши делятся на корзины, и для каждой корзины подбирается seed, при котором все её хэши
+// попадают в свободные ячейки (hash and displace). Поиск — одна корзина и одна ячейка.
+// В ячейке хранится отпечаток хэша, чтобы отсеивать названия, которых нет в наборе
+class PerfectNameHash {
+public:
+    // Ячейка хэша hashes[i] получает номер i. Возвращает false, если подобрать seed не удалось,
+    // например при совпадении 64-битных хэшей двух названий
+    bool Build(std::span<const uint64_t> hashes);
+
+    // Номер, чей отпечаток совпал с отпечатком hash. Само название вызывающий должен сравнить
+    std::optional<NameId> Find(uint64_t hash) const;
+
+    size_t GetSize() const {
+        return slot_names_.size();
+    }
+
+    template <typename Archive>
+    void Save(Archive& archive) const {
+        archive.WriteVector(bucket_seeds_);
+        archive.WriteVector(slot_names_);
+        archive.WriteVector(slot_fingerprints_);
+    }
+
+    // name_count — число названий в хранилище: ячейки должны ссылаться только на них
+    template <typename Archive>
+    void Load(Archive& archive, size_t name_count) {
+        bucket_seeds_ = archive.template ReadVector<uint32_t>();
+        slot_names_ = archive.template ReadVector<NameId>();
+        slot_fingerprints_ = archive.template ReadVector<uint32_t>();
+        if (!IsConsistentWith(name_count)) {
+            throw std::invalid_argument("Saved perfect name hash is inconsistent");
+        }
+    }
+
+private:
+    std::vector<uint32_t> bucket_seeds_;
+    std::vector<NameId> slot_names_;
+    std::vector<uint32_t> slot_fingerprints_;
+
+    bool IsConsistentWith(size_t name_count) const;
+    size_t GetBucket(uint64_t hash) const;
+    size_t GetSlot(uint64_t hash, uint32_t seed) const;
+};
+
+class NameArena {
+public:
+    NameArena() = default;
+    // Копия делит с other уже заполненные блоки: записанные названия не меняются, а новые
+    // копия и other пишут в разные места, поэтому string_view на названия other действуют и в копии
+    NameArena(const NameArena& other);
+    NameArena& operator=(const NameArena&) = delete;
+
+    // Номер названия. Если такого названия ещё нет, оно копируется в хранилище
+    NameId Intern(std::string_view name);
+    std::optional<NameId> Find(std::string_view name) const;
+
+    // Строит совершенную хэш-функцию по текущему набору названий. Названия, добавленные позже,
+    // ищутся обычной таблицей, пока Freeze не будет вызван снова
+    void Freeze();
+
+    // Названия в порядке номеров и совершенная хэш-функция. Load вызывается для пустого хранилища
+    template <typename Archive>
+    void Save(Archive& archive) const;
+    template <typename Archive>
+    void Load(Archive& archive);
+
+    std::string_view GetName(NameId name_id) const {
+        return names_[name_id];
+    }
+    uint64_t GetHash(NameId name_id) const {
+        return hashes_[name_id];
+    }
+    size_t GetNameCount() const {
+        return names_.size();
+    }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+    static constexpr NameId NO_NAME = UINT32_MAX;
+
+    std::vector<std::shared_ptr<char[]>> blocks_;
+    size_t block_capacity_ = 0; // Размер и заполненность последнего блока
+    size_t block_used_ = 0;
+    std::vector<std::string_view> names_; // Индекс — NameId
+    std::vector<uint64_t> hashes_;        // Индекс — NameId
+    std::vector<NameId> table_;           // Размер — степень двойки, заполнен не больше чем наполовину
+    PerfectNameHash perfect_hash_;        // Действует, пока названий столько же, сколько при Freeze
+
+    std::string_view Store(std::string_view name);
+    void Rehash(size_t table_size);
+    bool IsFrozen() const {
+        return !names_.empty() && perfect_hash_.GetSize() == names_.size();
+    }
+};
+
+template <typename Archive>
+void NameArena::Save(Archive& archive) const {
+    archive.Write(static_cast<uint64_t>(names_.size()));
+    for (const std::string_view name : names_) {
+        archive.WriteString(name);
+    }
+    archive.Write(IsFrozen());
+    if (IsFrozen()) {
+        perfect_hash_.Save(archive);
+    }
+}
+
+template <typename Archive>
+void NameArena::Load(Archive& archive) {
+    const size_t name_count = archive.template Read<uint64_t>();
+    for (size_t i = 0; i < name_count; ++i) {
+        Intern(archive.ReadString());
+    }
+    if (archive.template Read<bool>()) {
+        perfect_hash_.Load(archive, names_.size());
+    }
+}
+
+} // namespace transport
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "request_handler.h"
 
+#include <algorithm>
+
 /*
  * Здесь можно было бы разместить код обработчика запросов к базе, содержащего логику, которую не
  * хотелось бы помещать ни в transport_catalogue, ни в json reader.
@@ -9,15 +11,71 @@
  */
 
 svg::Document RequestHandler::RenderMap() const {
-    return renderer_.MakeSVGDocument(db_.GetBusesSortedByName());
+    // На карте только остановки, через которые проходит хотя бы один автобус
+    std::vector<const transport::Stop*> stops_with_buses;
+    for (const transport::Stop* stop : db_.GetStopsSortedByName()) {
+        if (!db_.GetStopToBuses(stop).empty()) {
+            stops_with_buses.push_back(stop);
+        }
+    }
+    return renderer_.MakeSVGDocument(db_.GetBusesSortedByName(), stops_with_buses);
 }
 
-const transport::TransportRouter::CompleteRouteInfo RequestHandler::GetOptimalRoute(
+std::optional<transport::TransportRouter::RouteView> RequestHandler::GetOptimalRoute(
     const std::string_view stop_from_name,
     const std::string_view stop_to_name
 ) const {
-    return transport_router_.FindOptimalRoute(
-        db_.FindStop(stop_from_name),
-        db_.FindStop(stop_to_name)
-    );
+    // Остановки может не быть в справочнике, например после её удаления
+    const transport::Stop* stop_from = db_.FindStop(stop_from_name);
+    const transport::Stop* stop_to = db_.FindStop(stop_to_name);
+    if (!stop_from || !stop_to) {
+        return std::nullopt;
+    }
+    return transport_router_.FindOptimalRoute(stop_from, stop_to);
+}
+
+std::optional<transport::TransportRouter::RouteTimesMatrix> RequestHandler::GetRouteTimes(
+    const std::vector<std::string_view>& stops_from_names,
+    const std::vector<std::string_view>& stops_to_names
+) const {
+    auto find_stops = [this](const std::vector<std::string_view>& stop_names) {
+        std::vector<const transport::Stop*> stops;
+        stops.reserve(stop_names.size());
+        for (const std::string_view stop_name : stop_names) {
+            stops.push_back(db_.FindStop(stop_name));
+        }
+        return stops;
+    };
+    const std::vector<const transport::Stop*> stops_from = find_stops(stops_from_names);
+    const std::vector<const transport::Stop*> stops_to = find_stops(stops_to_names);
+    const auto is_missing = [](const transport::Stop* stop) {
+        return stop == nullptr;
+    };
+    if (std::any_of(stops_from.begin(), stops_from.end(), is_missing)
+        || std::any_of(stops_to.begin(), stops_to.end(), is_missing))
+    {
+        return std::nullopt;
+    }
+    return transport_router_.FindRouteTimes(stops_from, stops_to);
+}
+
+std::vector<transport::NearbyStop> RequestHandler::GetNearestStops(
+    geo::Coordinates point,
+    size_t count,
+    double radius
+) const {
+    return stops_index_.FindNearestStops(point, count, radius);
+}
+
+std::optional<transport::TransportRouter::PointRoute> RequestHandler::GetOptimalRouteFromPoint(
+    geo::Coordinates point_from,
+    geo::Coordinates point_to
+) const {
+    const size_t stop_count = transport_router_.GetSettings().walk_stop_count;
+    const std::vector<transport::NearbyStop> stops_from = stops_index_.FindNearestStops(point_from, stop_count);
+    const std::vector<transport::NearbyStop> stops_to = stops_index_.FindNearestStops(point_to, stop_count);
+    if (stops_from.empty() || stops_to.empty()) {
+        return std::nullopt;
+    }
+    return transport_router_.FindOptimalRoute(stops_from, stops_to);
 }
\ No newline at end of file
@@ -37,6 +37,7 @@ private:
 */
 
 #include "map_renderer.h"
+#include "stops_index.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
 
@@ -46,21 +47,41 @@ public:
         const transport::TransportCatalogue& db,
         const renderer::MapRenderer& renderer,
         const transport::TransportRouter& transport_router) 
-    :db_(db), renderer_(renderer), transport_router_(transport_router)
+    :db_(db), renderer_(renderer), transport_router_(transport_router), stops_index_(db)
     {
 
     }
 
     svg::Document RenderMap() const;
     
-    const transport::TransportRouter::CompleteRouteInfo GetOptimalRoute(
+    std::optional<transport::TransportRouter::RouteView> GetOptimalRoute(
         const std::string_view stop_from_name,
         const std::string_view stop_to_name
     ) const;
 
+    // Матрица времён в пути между остановками. Если хотя бы одной остановки нет в справочнике, возвращает nullopt
+    std::optional<transport::TransportRouter::RouteTimesMatrix> GetRouteTimes(
+        const std::vector<std::string_view>& stops_from_names,
+        const std::vector<std::string_view>& stops_to_names
+    ) const;
+
+    // Остановки около точки: не более count ближайших и не дальше radius метров
+    std::vector<transport::NearbyStop> GetNearestStops(
+        geo::Coordinates point,
+        size_t count,
+        double radius
+    ) const;
+
+    // Маршрут между точками на карте через ближайшие к ним остановки
+    std::optional<transport::TransportRouter::PointRoute> GetOptimalRouteFromPoint(
+        geo::Coordinates point_from,
+        geo::Coordinates point_to
+    ) const;
+
 private:
     // RequestHandler использует агрегацию объектов "Транспортный Справочник" и "Визуализатор Карты"
     const transport::TransportCatalogue& db_;
     const renderer::MapRenderer& renderer_;
     const transport::TransportRouter& transport_router_;
+    const transport::StopsIndex stops_index_;
 };
\ No newline at end of file
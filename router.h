@@ -1,26 +1,41 @@
 #pragma once
 
+#include "contraction_hierarchies.h"
 #include "graph.h"
 
 #include <algorithm>
+#include <barrier>
 #include <cassert>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <limits>
 #include <optional>
+#include <queue>
 #include <stdexcept>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace graph {
 
+// Способ поиска кратчайших путей
+enum class RouterMode {
+    ALL_PAIRS, // Предподсчёт всех пар вершин (Флойд-Уоршелл): O(V^3) времени и O(V^2) памяти
+    DIJKSTRA,  // Алгоритм Дейкстры на каждый запрос: без предподсчёта, O(V + E) памяти
+    CONTRACTION_HIERARCHIES, // Иерархии сжатия: предподсчёт сокращений и двунаправленный поиск
+    ALL_PAIRS_BLOCKED, // Флойд-Уоршелл по плоской матрице, обрабатываемой блоками, помещающимися в кэш
+};
+
 template <typename Weight>
 class Router {
 private:
     using Graph = DirectedWeightedGraph<Weight>;
 
 public:
-    explicit Router(const Graph& graph);
+    // thread_count задаёт число потоков предподсчёта в режимах ALL_PAIRS, ALL_PAIRS_BLOCKED и CONTRACTION_HIERARCHIES
+    explicit Router(const Graph& graph, RouterMode mode = RouterMode::ALL_PAIRS, size_t thread_count = 1);
 
     struct RouteInfo {
         Weight weight;
@@ -29,6 +44,43 @@ public:
 
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+    // Вершина с добавкой к весу маршрута, например со временем, за которое до неё можно дойти
+    struct WeightedVertex {
+        VertexId vertex;
+        Weight weight;
+    };
+
+    struct MultiRouteInfo {
+        size_t source_index;
+        size_t target_index;
+        RouteInfo route; // Вес пути по графу без добавок источника и цели
+    };
+
+    // Лучший маршрут из любой вершины sources в любую вершину targets с учётом их добавок.
+    // В режиме DIJKSTRA это один поиск сразу из всех источников, в остальных режимах
+    // пары сравниваются по матрице весов, а путь восстанавливается только для лучшей
+    std::optional<MultiRouteInfo> BuildRoute(const std::vector<WeightedVertex>& sources,
+                                             const std::vector<WeightedVertex>& targets) const;
+
+    // Веса кратчайших путей от каждой вершины sources до каждой вершины targets, без восстановления путей.
+    // Выполняется один поиск на источник, а в режиме иерархий сжатия — общий поиск с корзинами
+    using WeightsMatrix = std::vector<std::vector<std::optional<Weight>>>;
+    WeightsMatrix BuildWeightsMatrix(const std::vector<VertexId>& sources,
+                                     const std::vector<VertexId>& targets) const;
+
+    // Восстанавливает маршрутизатор из данных, сохранённых методом Save, без повторного предподсчёта.
+    // Архив передаётся первым, чтобы этот конструктор нельзя было спутать с основным
+    template <typename Archive>
+    Router(Archive& archive, const Graph& graph);
+
+    // Archive должен предоставлять Write(value) и WriteVector(vector) для тривиально копируемых типов
+    template <typename Archive>
+    void Save(Archive& archive) const;
+
+    RouterMode GetMode() const {
+        return mode_;
+    }
+
 private:
     struct RouteInternalData {
         Weight weight;
@@ -36,6 +88,14 @@ private:
     };
     using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
 
+    static void CheckEdgesWeights(const Graph& graph) {
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+    }
+
     void InitializeRoutesInternalData(const Graph& graph) {
         const size_t vertex_count = graph.GetVertexCount();
         for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
@@ -63,8 +123,9 @@ private:
         }
     }
 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
+    void RelaxRoutesInternalDataThroughVertex(VertexId rows_begin, VertexId rows_end,
+                                              size_t vertex_count, VertexId vertex_through) {
+        for (VertexId vertex_from = rows_begin; vertex_from < rows_end; ++vertex_from) {
             if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
                 for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
                     if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
@@ -75,42 +136,556 @@ private:
         }
     }
 
+    // При фиксированной vertex_through строка и столбец vertex_through не меняются,
+    // а остальные строки обновляются независимо. Поэтому строки делятся между потоками,
+    // которые синхронизируются барьером после каждой vertex_through, и результат
+    // совпадает с однопоточным вплоть до выбора prev_edge
+    void RelaxRoutesInternalDataInParallel(size_t vertex_count, size_t thread_count) {
+        thread_count = std::max<size_t>(1, std::min(thread_count, vertex_count));
+        std::barrier sync_point(static_cast<std::ptrdiff_t>(thread_count));
+        auto relax_rows = [this, vertex_count, &sync_point](VertexId rows_begin, VertexId rows_end) {
+            for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+                RelaxRoutesInternalDataThroughVertex(rows_begin, rows_end, vertex_count, vertex_through);
+                sync_point.arrive_and_wait();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(thread_count - 1);
+        const size_t rows_per_thread = vertex_count / thread_count;
+        const size_t extra_rows = vertex_count % thread_count;
+        VertexId rows_begin = 0;
+        for (size_t thread_index = 0; thread_index < thread_count; ++thread_index) {
+            const VertexId rows_end = rows_begin + rows_per_thread + (thread_index < extra_rows ? 1 : 0);
+            if (thread_index + 1 == thread_count) {
+                relax_rows(rows_begin, rows_end);
+            } else {
+                workers.emplace_back(relax_rows, rows_begin, rows_end);
+            }
+            rows_begin = rows_end;
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Плоская матрица маршрутов для режима ALL_PAIRS_BLOCKED: веса и последние рёбра
+    // хранятся в двух отдельных массивах по строкам, отсутствие маршрута обозначается
+    // бесконечным весом, а отсутствие ребра — NO_LAST_EDGE. Ячейка занимает
+    // sizeof(Weight) + 4 байта вместо sizeof(std::optional<RouteInternalData>)
+    void InitializeFlatRoutes(const Graph& graph) {
+        if constexpr (!std::numeric_limits<Weight>::has_infinity) {
+            throw std::invalid_argument("Blocked all-pairs mode requires floating-point weights");
+        }
+        if (graph.GetEdgeCount() >= NO_LAST_EDGE) {
+            throw std::length_error("Too many edges for blocked all-pairs mode");
+        }
+        const size_t vertex_count = graph.GetVertexCount();
+        route_weights_.assign(vertex_count * vertex_count, UNREACHABLE_WEIGHT);
+        route_last_edges_.assign(vertex_count * vertex_count, NO_LAST_EDGE);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            route_weights_[vertex * vertex_count + vertex] = ZERO_WEIGHT;
+            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+                const auto& edge = graph.GetEdge(edge_id);
+                if (edge.weight < ZERO_WEIGHT) {
+                    throw std::domain_error("Edges' weights should be non-negative");
+                }
+                const size_t cell = vertex * vertex_count + edge.to;
+                if (edge.weight < route_weights_[cell]) {
+                    route_weights_[cell] = edge.weight;
+                    route_last_edges_[cell] = static_cast<uint32_t>(edge_id);
+                }
+            }
+        }
+    }
+
+    // Релаксация блока строк block_from и столбцов block_to через вершины блока block_through.
+    // Ячейки на диагонали нулевые, поэтому улучшение возможно только при vertex_through != vertex_to,
+    // и последним ребром маршрута становится последнее ребро маршрута vertex_through -> vertex_to
+    void RelaxFlatRoutesBlock(size_t block_from, size_t block_to, size_t block_through, size_t vertex_count) {
+        const size_t rows_end = std::min(vertex_count, (block_from + 1) * BLOCK_SIZE);
+        const size_t columns_begin = block_to * BLOCK_SIZE;
+        const size_t columns_end = std::min(vertex_count, columns_begin + BLOCK_SIZE);
+        const size_t through_end = std::min(vertex_count, (block_through + 1) * BLOCK_SIZE);
+        for (VertexId vertex_through = block_through * BLOCK_SIZE; vertex_through < through_end; ++vertex_through) {
+            const Weight* weights_through = &route_weights_[vertex_through * vertex_count];
+            const uint32_t* last_edges_through = &route_last_edges_[vertex_through * vertex_count];
+            for (VertexId vertex_from = block_from * BLOCK_SIZE; vertex_from < rows_end; ++vertex_from) {
+                Weight* weights_from = &route_weights_[vertex_from * vertex_count];
+                const Weight weight_from = weights_from[vertex_through];
+                if (weight_from == UNREACHABLE_WEIGHT) {
+                    continue;
+                }
+                uint32_t* last_edges_from = &route_last_edges_[vertex_from * vertex_count];
+                // Цикл без ветвлений, чтобы компилятор мог его векторизовать
+                for (VertexId vertex_to = columns_begin; vertex_to < columns_end; ++vertex_to) {
+                    const Weight candidate_weight = weight_from + weights_through[vertex_to];
+                    const bool is_better = candidate_weight < weights_from[vertex_to];
+                    weights_from[vertex_to] = is_better ? candidate_weight : weights_from[vertex_to];
+                    last_edges_from[vertex_to] = is_better ? last_edges_through[vertex_to] : last_edges_from[vertex_to];
+                }
+            }
+        }
+    }
+
+    // Блочный Флойд-Уоршелл: для каждого диагонального блока сначала обновляется он сам,
+    // затем блоки его строки и столбца, затем все остальные. Внутри второй и третьей фаз
+    // блоки независимы и распределяются между потоками, так что результат от числа потоков
+    // не зависит. Веса совпадают с ALL_PAIRS, но промежуточные вершины блока учитываются
+    // раньше, чем в построчном порядке, и из маршрутов равного веса может быть выбран другой
+    void RelaxFlatRoutesBlocked(size_t vertex_count, size_t thread_count) {
+        const size_t block_count = (vertex_count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        thread_count = std::max<size_t>(1, std::min(thread_count, block_count));
+        std::barrier sync_point(static_cast<std::ptrdiff_t>(thread_count));
+        auto relax_blocks = [this, vertex_count, block_count, thread_count, &sync_point](size_t thread_index) {
+            for (size_t block_through = 0; block_through < block_count; ++block_through) {
+                if (thread_index == 0) {
+                    RelaxFlatRoutesBlock(block_through, block_through, block_through, vertex_count);
+                }
+                sync_point.arrive_and_wait();
+                for (size_t block = thread_index; block < block_count; block += thread_count) {
+                    if (block != block_through) {
+                        RelaxFlatRoutesBlock(block_through, block, block_through, vertex_count);
+                        RelaxFlatRoutesBlock(block, block_through, block_through, vertex_count);
+                    }
+                }
+                sync_point.arrive_and_wait();
+                for (size_t block_from = thread_index; block_from < block_count; block_from += thread_count) {
+                    if (block_from == block_through) {
+                        continue;
+                    }
+                    for (size_t block_to = 0; block_to < block_count; ++block_to) {
+                        if (block_to != block_through) {
+                            RelaxFlatRoutesBlock(block_from, block_to, block_through, vertex_count);
+                        }
+                    }
+                }
+                sync_point.arrive_and_wait();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(thread_count - 1);
+        for (size_t thread_index = 1; thread_index < thread_count; ++thread_index) {
+            workers.emplace_back(relax_blocks, thread_index);
+        }
+        relax_blocks(0);
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    std::optional<RouteInfo> BuildRouteFromFlatRoutes(VertexId from, VertexId to) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        if (from >= vertex_count || to >= vertex_count) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        const Weight weight = route_weights_[from * vertex_count + to];
+        if (weight == UNREACHABLE_WEIGHT) {
+            return std::nullopt;
+        }
+        const uint32_t* last_edges_from = route_last_edges_.data() + from * vertex_count;
+        auto last_edge = [last_edges_from](VertexId vertex) {
+            const uint32_t edge_id = last_edges_from[vertex];
+            return edge_id == NO_LAST_EDGE ? std::nullopt : std::optional<EdgeId>(edge_id);
+        };
+        std::vector<EdgeId> edges = UnwindRoute(last_edge(to), [this, &last_edge](EdgeId edge_id) {
+            return last_edge(graph_.GetEdge(edge_id).from);
+        });
+        return RouteInfo{weight, std::move(edges)};
+    }
+
+    // Восстанавливает путь по цепочке последних рёбер, начиная с last_edge. Сначала проходит
+    // цепочку, чтобы узнать длину пути, и заполняет вектор с конца без лишних перевыделений
+    template <typename PrevEdge>
+    std::vector<EdgeId> UnwindRoute(std::optional<EdgeId> last_edge, PrevEdge prev_edge) const {
+        size_t edge_count = 0;
+        for (std::optional<EdgeId> edge_id = last_edge; edge_id; edge_id = prev_edge(*edge_id)) {
+            ++edge_count;
+        }
+        std::vector<EdgeId> edges(edge_count);
+        for (std::optional<EdgeId> edge_id = last_edge; edge_id; edge_id = prev_edge(*edge_id)) {
+            edges[--edge_count] = *edge_id;
+        }
+        return edges;
+    }
+
+    void CheckVertexId(VertexId vertex) const {
+        if (vertex >= graph_.GetVertexCount()) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+    }
+
+    // Алгоритм Дейкстры по CSR-представлению графа из одной или нескольких вершин с начальными весами.
+    // Поиск прекращается, как только is_finished(vertex, weight) вернёт true для очередной вершины
+    // с окончательно найденным весом. Вся память поиска локальна, поэтому его можно выполнять
+    // одновременно из нескольких потоков
+    template <typename FinishPredicate>
+    std::vector<std::optional<RouteInternalData>> RunDijkstra(const std::vector<WeightedVertex>& sources,
+                                                              FinishPredicate is_finished) const {
+        std::vector<std::optional<RouteInternalData>> routes_from(graph_.GetVertexCount());
+        using QueueItem = std::pair<Weight, VertexId>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+
+        for (const auto& [source, source_weight] : sources) {
+            auto& route_from = routes_from[source];
+            if (!route_from || source_weight < route_from->weight) {
+                route_from = RouteInternalData{source_weight, std::nullopt};
+                queue.push({source_weight, source});
+            }
+        }
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (routes_from[vertex]->weight < weight) {
+                continue; // Устаревшая запись очереди
+            }
+            if (is_finished(vertex, weight)) {
+                break;
+            }
+            const size_t edges_end = frozen_graph_.GetEdgesEnd(vertex);
+            for (size_t position = frozen_graph_.GetEdgesBegin(vertex); position < edges_end; ++position) {
+                const VertexId vertex_to = frozen_graph_.GetTarget(position);
+                const Weight candidate_weight = weight + frozen_graph_.GetWeight(position);
+                auto& route_to = routes_from[vertex_to];
+                if (!route_to || candidate_weight < route_to->weight) {
+                    route_to = RouteInternalData{candidate_weight, frozen_graph_.GetEdgeId(position)};
+                    queue.push({candidate_weight, vertex_to});
+                }
+            }
+        }
+        return routes_from;
+    }
+
+    std::optional<RouteInfo> BuildRouteWithDijkstra(VertexId from, VertexId to) const {
+        CheckVertexId(from);
+        CheckVertexId(to);
+        const auto routes_from = RunDijkstra({{from, ZERO_WEIGHT}}, [to](VertexId vertex, Weight) {
+            return vertex == to;
+        });
+
+        if (!routes_from[to]) {
+            return std::nullopt;
+        }
+        std::vector<EdgeId> edges = UnwindRoute(routes_from[to]->prev_edge, [this, &routes_from](EdgeId edge_id) {
+            return routes_from[graph_.GetEdge(edge_id).from]->prev_edge;
+        });
+        return RouteInfo{routes_from[to]->weight, std::move(edges)};
+    }
+
+    std::optional<MultiRouteInfo> BuildMultiRouteWithDijkstra(const std::vector<WeightedVertex>& sources,
+                                                              const std::vector<WeightedVertex>& targets) const {
+        // Для каждой вершины — цель с наименьшей добавкой
+        static constexpr size_t NO_TARGET = std::numeric_limits<size_t>::max();
+        std::vector<size_t> vertex_targets(graph_.GetVertexCount(), NO_TARGET);
+        for (size_t target_index = 0; target_index < targets.size(); ++target_index) {
+            size_t& vertex_target = vertex_targets[targets[target_index].vertex];
+            if (vertex_target == NO_TARGET || targets[target_index].weight < targets[vertex_target].weight) {
+                vertex_target = target_index;
+            }
+        }
+
+        // Цели снимаются по возрастанию веса пути, поэтому поиск заканчивается, как только
+        // вес очередной вершины не меньше лучшего найденного веса с добавкой цели
+        std::optional<Weight> best_weight;
+        size_t best_target = NO_TARGET;
+        const auto routes_from = RunDijkstra(sources, [&](VertexId vertex, Weight weight) {
+            if (best_weight && !(weight < *best_weight)) {
+                return true;
+            }
+            if (const size_t target_index = vertex_targets[vertex]; target_index != NO_TARGET) {
+                const Weight candidate_weight = weight + targets[target_index].weight;
+                if (!best_weight || candidate_weight < *best_weight) {
+                    best_weight = candidate_weight;
+                    best_target = target_index;
+                }
+            }
+            return false;
+        });
+        if (!best_weight) {
+            return std::nullopt;
+        }
+
+        const VertexId to = targets[best_target].vertex;
+        std::vector<EdgeId> edges = UnwindRoute(routes_from[to]->prev_edge, [this, &routes_from](EdgeId edge_id) {
+            return routes_from[graph_.GetEdge(edge_id).from]->prev_edge;
+        });
+        // Путь начинается в источнике с наименьшей добавкой среди стоящих в первой вершине пути
+        const VertexId from = edges.empty() ? to : graph_.GetEdge(edges.front()).from;
+        size_t best_source = 0;
+        for (size_t source_index = 0; source_index < sources.size(); ++source_index) {
+            if (sources[source_index].vertex == from
+                && (sources[best_source].vertex != from || sources[source_index].weight < sources[best_source].weight))
+            {
+                best_source = source_index;
+            }
+        }
+        const Weight route_weight = routes_from[to]->weight - sources[best_source].weight;
+        return MultiRouteInfo{best_source, best_target, RouteInfo{route_weight, std::move(edges)}};
+    }
+
+    std::vector<std::optional<Weight>> BuildWeightsWithDijkstra(VertexId from, const std::vector<VertexId>& targets) const {
+        std::vector<bool> is_target(graph_.GetVertexCount(), false);
+        size_t targets_left = 0;
+        for (const VertexId target : targets) {
+            if (!is_target[target]) {
+                is_target[target] = true;
+                ++targets_left;
+            }
+        }
+        const auto routes_from = RunDijkstra({{from, ZERO_WEIGHT}}, [&is_target, &targets_left](VertexId vertex, Weight) {
+            if (!is_target[vertex]) {
+                return false;
+            }
+            is_target[vertex] = false;
+            return --targets_left == 0;
+        });
+
+        std::vector<std::optional<Weight>> weights;
+        weights.reserve(targets.size());
+        for (const VertexId target : targets) {
+            weights.push_back(routes_from[target] ? std::optional<Weight>(routes_from[target]->weight) : std::nullopt);
+        }
+        return weights;
+    }
+
     static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight UNREACHABLE_WEIGHT = std::numeric_limits<Weight>::has_infinity
+        ? std::numeric_limits<Weight>::infinity()
+        : std::numeric_limits<Weight>::max();
+    static constexpr uint32_t NO_LAST_EDGE = std::numeric_limits<uint32_t>::max();
+    static constexpr EdgeId NO_SAVED_EDGE = std::numeric_limits<EdgeId>::max();
+    // 64 x 64 весов типа double занимают 32 КБ — блок помещается в кэш L1/L2
+    static constexpr size_t BLOCK_SIZE = 64;
+
     const Graph& graph_;
+    const RouterMode mode_;
     RoutesInternalData routes_internal_data_;
+    FrozenDirectedWeightedGraph<Weight> frozen_graph_;
+    std::optional<ContractionHierarchies<Weight>> hierarchies_;
+    std::vector<Weight> route_weights_;
+    std::vector<uint32_t> route_last_edges_;
 };
 
 template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+Router<Weight>::Router(const Graph& graph, RouterMode mode, size_t thread_count)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , mode_(mode)
 {
+    if (mode_ == RouterMode::DIJKSTRA) {
+        CheckEdgesWeights(graph);
+        frozen_graph_ = FrozenDirectedWeightedGraph<Weight>(graph);
+        return;
+    }
+    if (mode_ == RouterMode::CONTRACTION_HIERARCHIES) {
+        hierarchies_.emplace(graph, thread_count);
+        return;
+    }
+    if (mode_ == RouterMode::ALL_PAIRS_BLOCKED) {
+        InitializeFlatRoutes(graph);
+        RelaxFlatRoutesBlocked(graph.GetVertexCount(), thread_count);
+        return;
+    }
+
+    routes_internal_data_.assign(graph.GetVertexCount(),
+                                 std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()));
     InitializeRoutesInternalData(graph);
 
     const size_t vertex_count = graph.GetVertexCount();
+    if (thread_count > 1) {
+        RelaxRoutesInternalDataInParallel(vertex_count, thread_count);
+        return;
+    }
     for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+        RelaxRoutesInternalDataThroughVertex(0, vertex_count, vertex_count, vertex_through);
+    }
+}
+
+template <typename Weight>
+std::optional<typename Router<Weight>::MultiRouteInfo> Router<Weight>::BuildRoute(
+    const std::vector<WeightedVertex>& sources,
+    const std::vector<WeightedVertex>& targets
+) const {
+    std::vector<VertexId> source_vertexes;
+    source_vertexes.reserve(sources.size());
+    for (const WeightedVertex& source : sources) {
+        CheckVertexId(source.vertex);
+        source_vertexes.push_back(source.vertex);
+    }
+    std::vector<VertexId> target_vertexes;
+    target_vertexes.reserve(targets.size());
+    for (const WeightedVertex& target : targets) {
+        CheckVertexId(target.vertex);
+        target_vertexes.push_back(target.vertex);
+    }
+    if (mode_ == RouterMode::DIJKSTRA) {
+        return BuildMultiRouteWithDijkstra(sources, targets);
+    }
+
+    const WeightsMatrix weights = BuildWeightsMatrix(source_vertexes, target_vertexes);
+    std::optional<Weight> best_weight;
+    size_t best_source = 0;
+    size_t best_target = 0;
+    for (size_t source_index = 0; source_index < sources.size(); ++source_index) {
+        for (size_t target_index = 0; target_index < targets.size(); ++target_index) {
+            if (!weights[source_index][target_index]) {
+                continue;
+            }
+            const Weight candidate_weight = sources[source_index].weight + *weights[source_index][target_index]
+                + targets[target_index].weight;
+            if (!best_weight || candidate_weight < *best_weight) {
+                best_weight = candidate_weight;
+                best_source = source_index;
+                best_target = target_index;
+            }
+        }
+    }
+    if (!best_weight) {
+        return std::nullopt;
+    }
+    std::optional<RouteInfo> route = BuildRoute(sources[best_source].vertex, targets[best_target].vertex);
+    return MultiRouteInfo{best_source, best_target, std::move(*route)};
+}
+
+template <typename Weight>
+typename Router<Weight>::WeightsMatrix Router<Weight>::BuildWeightsMatrix(const std::vector<VertexId>& sources,
+                                                                          const std::vector<VertexId>& targets) const {
+    for (const VertexId vertex : sources) {
+        CheckVertexId(vertex);
+    }
+    for (const VertexId vertex : targets) {
+        CheckVertexId(vertex);
+    }
+    if (mode_ == RouterMode::CONTRACTION_HIERARCHIES) {
+        return hierarchies_->FindWeights(sources, targets);
+    }
+
+    WeightsMatrix weights;
+    weights.reserve(sources.size());
+    const size_t vertex_count = graph_.GetVertexCount();
+    for (const VertexId from : sources) {
+        if (mode_ == RouterMode::DIJKSTRA) {
+            weights.push_back(BuildWeightsWithDijkstra(from, targets));
+            continue;
+        }
+        std::vector<std::optional<Weight>>& weights_from = weights.emplace_back();
+        weights_from.reserve(targets.size());
+        for (const VertexId to : targets) {
+            if (mode_ == RouterMode::ALL_PAIRS_BLOCKED) {
+                const Weight weight = route_weights_[from * vertex_count + to];
+                weights_from.push_back(weight == UNREACHABLE_WEIGHT ? std::nullopt : std::optional<Weight>(weight));
+            } else {
+                const auto& route_internal_data = routes_internal_data_[from][to];
+                weights_from.push_back(route_internal_data ? std::optional<Weight>(route_internal_data->weight) : std::nullopt);
+            }
+        }
+    }
+    return weights;
+}
+
+template <typename Weight>
+template <typename Archive>
+Router<Weight>::Router(Archive& archive, const Graph& graph)
+    : graph_(graph)
+    , mode_(static_cast<RouterMode>(archive.template Read<uint32_t>()))
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    switch (mode_) {
+        case RouterMode::ALL_PAIRS: {
+            // Таблица хранится в плоском виде: бесконечный вес означает отсутствие маршрута
+            const std::vector<Weight> weights = archive.template ReadVector<Weight>();
+            const std::vector<EdgeId> prev_edges = archive.template ReadVector<EdgeId>();
+            if (weights.size() != vertex_count * vertex_count || prev_edges.size() != weights.size()) {
+                throw std::invalid_argument("Saved routes don't match the graph");
+            }
+            routes_internal_data_.assign(vertex_count, std::vector<std::optional<RouteInternalData>>(vertex_count));
+            for (size_t cell = 0; cell < weights.size(); ++cell) {
+                if (weights[cell] != UNREACHABLE_WEIGHT) {
+                    routes_internal_data_[cell / vertex_count][cell % vertex_count] = RouteInternalData{
+                        weights[cell],
+                        prev_edges[cell] == NO_SAVED_EDGE ? std::nullopt : std::optional<EdgeId>(prev_edges[cell])
+                    };
+                }
+            }
+            break;
+        }
+        case RouterMode::ALL_PAIRS_BLOCKED:
+            route_weights_ = archive.template ReadVector<Weight>();
+            route_last_edges_ = archive.template ReadVector<uint32_t>();
+            if (route_weights_.size() != vertex_count * vertex_count || route_last_edges_.size() != route_weights_.size()) {
+                throw std::invalid_argument("Saved routes don't match the graph");
+            }
+            break;
+        case RouterMode::DIJKSTRA:
+            // CSR-представление строится за один линейный проход по рёбрам
+            frozen_graph_ = FrozenDirectedWeightedGraph<Weight>(graph);
+            break;
+        case RouterMode::CONTRACTION_HIERARCHIES:
+            hierarchies_.emplace(ContractionHierarchies<Weight>::Load(archive, graph));
+            break;
+        default:
+            throw std::invalid_argument("Unknown saved router mode");
+    }
+}
+
+template <typename Weight>
+template <typename Archive>
+void Router<Weight>::Save(Archive& archive) const {
+    archive.Write(static_cast<uint32_t>(mode_));
+    switch (mode_) {
+        case RouterMode::ALL_PAIRS: {
+            std::vector<Weight> weights;
+            std::vector<EdgeId> prev_edges;
+            weights.reserve(routes_internal_data_.size() * routes_internal_data_.size());
+            prev_edges.reserve(weights.capacity());
+            for (const auto& routes_from : routes_internal_data_) {
+                for (const auto& route : routes_from) {
+                    weights.push_back(route ? route->weight : UNREACHABLE_WEIGHT);
+                    prev_edges.push_back(route && route->prev_edge ? *route->prev_edge : NO_SAVED_EDGE);
+                }
+            }
+            archive.WriteVector(weights);
+            archive.WriteVector(prev_edges);
+            break;
+        }
+        case RouterMode::ALL_PAIRS_BLOCKED:
+            archive.WriteVector(route_weights_);
+            archive.WriteVector(route_last_edges_);
+            break;
+        case RouterMode::DIJKSTRA:
+            break;
+        case RouterMode::CONTRACTION_HIERARCHIES:
+            hierarchies_->Save(archive);
+            break;
     }
 }
 
 template <typename Weight>
 std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
                                                                              VertexId to) const {
+    if (mode_ == RouterMode::DIJKSTRA) {
+        return BuildRouteWithDijkstra(from, to);
+    }
+    if (mode_ == RouterMode::CONTRACTION_HIERARCHIES) {
+        auto path = hierarchies_->FindPath(from, to);
+        if (!path) {
+            return std::nullopt;
+        }
+        return RouteInfo{path->weight, std::move(path->edges)};
+    }
+    if (mode_ == RouterMode::ALL_PAIRS_BLOCKED) {
+        return BuildRouteFromFlatRoutes(from, to);
+    }
+
     const auto& route_internal_data = routes_internal_data_.at(from).at(to);
     if (!route_internal_data) {
         return std::nullopt;
     }
     const Weight weight = route_internal_data->weight;
-    std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
-    {
-        edges.push_back(*edge_id);
-    }
-    std::reverse(edges.begin(), edges.end());
-
+    const auto& routes_from = routes_internal_data_[from];
+    std::vector<EdgeId> edges = UnwindRoute(route_internal_data->prev_edge, [this, &routes_from](EdgeId edge_id) {
+        return routes_from[graph_.GetEdge(edge_id).from]->prev_edge;
+    });
     return RouteInfo{weight, std::move(edges)};
 }
 
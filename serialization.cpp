@@ -0,0 +1,296 @@
+#include "serialization.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <thread>
+
+namespace serialization {
+
+namespace {
+using namespace std::literals;
+
+// Остановки и автобусы записываются своими номерами. Справочник сохраняется в порядке номеров,
+// поэтому при загрузке они получают те же номера
+class BaseWriter : public BinaryWriter {
+public:
+    using BinaryWriter::BinaryWriter;
+
+    void WriteStop(const transport::Stop* stop) {
+        Write(stop->id);
+    }
+    void WriteBus(const transport::Bus* bus) {
+        Write(bus->id);
+    }
+};
+
+class BaseReader : public BinaryReader {
+public:
+    BaseReader(const char* begin, const char* end, const transport::TransportCatalogue& catalogue)
+    : BinaryReader(begin, end), catalogue_(catalogue)
+    {
+
+    }
+
+    const transport::Stop* ReadStop() {
+        return catalogue_.GetStop(Read<transport::StopId>());
+    }
+    const transport::Bus* ReadBus() {
+        return catalogue_.GetBus(Read<transport::BusId>());
+    }
+
+private:
+    const transport::TransportCatalogue& catalogue_;
+};
+
+void SaveCatalogue(BaseWriter& writer, const transport::TransportCatalogue& catalogue) {
+    catalogue.SaveNames(writer);
+    const auto& stops = catalogue.GetStops();
+    writer.Write(static_cast<uint64_t>(stops.size()));
+    for (const transport::Stop& stop : stops) {
+        writer.WriteString(stop.stop_name);
+        writer.Write(stop.coordinates);
+    }
+    // Удалённые остановки и автобусы сохраняются, чтобы у остальных не сдвинулись номера
+    std::vector<transport::StopId> removed_stops;
+    for (const transport::Stop& stop : stops) {
+        if (catalogue.IsStopRemoved(stop.id)) {
+            removed_stops.push_back(stop.id);
+        }
+    }
+    writer.WriteVector(removed_stops);
+
+    // Сохраняются только явно заданные расстояния, обратные направления восстановятся при загрузке
+    uint64_t distances_amount = 0;
+    for (const transport::Stop& stop : stops) {
+        for (const transport::RoadDistance& road_distance : catalogue.GetRoadDistances(stop.id)) {
+            distances_amount += road_distance.is_explicit;
+        }
+    }
+    writer.Write(distances_amount);
+    for (const transport::Stop& stop : stops) {
+        for (const transport::RoadDistance& road_distance : catalogue.GetRoadDistances(stop.id)) {
+            if (road_distance.is_explicit) {
+                writer.WriteStop(&stop);
+                writer.WriteStop(catalogue.GetStop(road_distance.to));
+                writer.Write(road_distance.distance);
+            }
+        }
+    }
+
+    const auto& buses = catalogue.GetBuses();
+    writer.Write(static_cast<uint64_t>(buses.size()));
+    for (const transport::Bus& bus : buses) {
+        writer.WriteString(bus.bus_name);
+        writer.Write(bus.is_roundtrip);
+        writer.Write(static_cast<uint64_t>(bus.stops.size()));
+        for (const transport::Stop* stop : bus.stops) {
+            writer.WriteStop(stop);
+        }
+    }
+    std::vector<transport::BusId> removed_buses;
+    for (const transport::Bus& bus : buses) {
+        if (catalogue.IsBusRemoved(bus.id)) {
+            removed_buses.push_back(bus.id);
+        }
+    }
+    writer.WriteVector(removed_buses);
+}
+
+void LoadCatalogue(BaseReader& reader, transport::TransportCatalogue& catalogue) {
+    catalogue.LoadNames(reader);
+    const size_t stops_amount = reader.Read<uint64_t>();
+    for (size_t i = 0; i < stops_amount; ++i) {
+        std::string stop_name = reader.ReadString();
+        const geo::Coordinates coordinates = reader.Read<geo::Coordinates>();
+        catalogue.AddStop({stop_name, coordinates});
+    }
+    for (const transport::StopId stop_id : reader.ReadVector<transport::StopId>()) {
+        catalogue.RemoveStop(catalogue.GetStop(stop_id));
+    }
+
+    const size_t distances_amount = reader.Read<uint64_t>();
+    for (size_t i = 0; i < distances_amount; ++i) {
+        const transport::Stop* from = reader.ReadStop();
+        const transport::Stop* to = reader.ReadStop();
+        catalogue.SetDistanceBetweenStops(from, to, reader.Read<int>());
+    }
+
+    const size_t buses_amount = reader.Read<uint64_t>();
+    for (size_t i = 0; i < buses_amount; ++i) {
+        std::string bus_name = reader.ReadString();
+        const bool is_roundtrip = reader.Read<bool>();
+        std::vector<const transport::Stop*> bus_stops(reader.Read<uint64_t>());
+        for (const transport::Stop*& stop : bus_stops) {
+            stop = reader.ReadStop();
+        }
+        catalogue.AddBus({bus_name, std::move(bus_stops), is_roundtrip});
+    }
+    for (const transport::BusId bus_id : reader.ReadVector<transport::BusId>()) {
+        catalogue.RemoveBus(catalogue.GetBus(bus_id));
+    }
+    catalogue.Freeze(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+void SaveColor(BinaryWriter& writer, const svg::Color& color) {
+    writer.Write(static_cast<uint8_t>(color.index()));
+    if (const auto* name = std::get_if<std::string>(&color)) {
+        writer.WriteString(*name);
+    } else if (const auto* rgb = std::get_if<svg::Rgb>(&color)) {
+        writer.Write(*rgb);
+    } else if (const auto* rgba = std::get_if<svg::Rgba>(&color)) {
+        writer.Write(*rgba);
+    }
+}
+
+svg::Color LoadColor(BinaryReader& reader) {
+    switch (reader.Read<uint8_t>()) {
+        case 1:
+            return reader.ReadString();
+        case 2:
+            return reader.Read<svg::Rgb>();
+        case 3:
+            return reader.Read<svg::Rgba>();
+        default:
+            return svg::NoneColor;
+    }
+}
+
+void SaveRenderSettings(BinaryWriter& writer, const renderer::RenderSettings& render_settings) {
+    writer.Write(render_settings.width);
+    writer.Write(render_settings.height);
+    writer.Write(render_settings.padding);
+    writer.Write(render_settings.line_width);
+    writer.Write(render_settings.stop_radius);
+    writer.Write(render_settings.bus_label_font_size);
+    writer.Write(render_settings.bus_label_offset);
+    writer.Write(render_settings.stop_label_font_size);
+    writer.Write(render_settings.stop_label_offset);
+    SaveColor(writer, render_settings.underlayer_color);
+    writer.Write(render_settings.underlayer_width);
+    writer.Write(static_cast<uint64_t>(render_settings.color_palette.size()));
+    for (const svg::Color& color : render_settings.color_palette) {
+        SaveColor(writer, color);
+    }
+}
+
+renderer::RenderSettings LoadRenderSettings(BinaryReader& reader) {
+    renderer::RenderSettings render_settings;
+    render_settings.width = reader.Read<double>();
+    render_settings.height = reader.Read<double>();
+    render_settings.padding = reader.Read<double>();
+    render_settings.line_width = reader.Read<double>();
+    render_settings.stop_radius = reader.Read<double>();
+    render_settings.bus_label_font_size = reader.Read<int>();
+    render_settings.bus_label_offset = reader.Read<svg::Point>();
+    render_settings.stop_label_font_size = reader.Read<int>();
+    render_settings.stop_label_offset = reader.Read<svg::Point>();
+    render_settings.underlayer_color = LoadColor(reader);
+    render_settings.underlayer_width = reader.Read<double>();
+    render_settings.color_palette.resize(reader.Read<uint64_t>());
+    for (svg::Color& color : render_settings.color_palette) {
+        color = LoadColor(reader);
+    }
+    return render_settings;
+}
+
+} // namespace
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Can't open base file "s + path.string());
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        throw std::runtime_error("Can't read base file "s + path.string());
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+    if (size_ > 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Can't map base file "s + path.string());
+        }
+        data_ = static_cast<const char*>(data);
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+void WriteBase(
+    std::ostream& output,
+    const transport::TransportCatalogue& catalogue,
+    const renderer::RenderSettings& render_settings,
+    const transport::TransportRouter& router
+) {
+    BaseWriter writer(output);
+    output.write(BASE_FILE_SIGNATURE.data(), BASE_FILE_SIGNATURE.size());
+    writer.Write(BASE_FILE_VERSION);
+
+    SaveCatalogue(writer, catalogue);
+    SaveRenderSettings(writer, render_settings);
+    router.Save(writer);
+}
+
+// Пустой указатель означает, что данные — не файл базы
+std::unique_ptr<Base> ReadBase(const char* begin, const char* end) {
+    if (static_cast<size_t>(end - begin) < BASE_FILE_SIGNATURE.size()
+        || std::string_view(begin, BASE_FILE_SIGNATURE.size()) != BASE_FILE_SIGNATURE)
+    {
+        return nullptr;
+    }
+    auto base = std::make_unique<Base>();
+    BaseReader reader(begin + BASE_FILE_SIGNATURE.size(), end, base->catalogue);
+    if (const uint32_t version = reader.Read<uint32_t>(); version != BASE_FILE_VERSION) {
+        throw std::runtime_error("Unsupported base file version "s + std::to_string(version));
+    }
+
+    LoadCatalogue(reader, base->catalogue);
+    base->render_settings = LoadRenderSettings(reader);
+    base->router = transport::TransportRouter::Load(reader);
+    return base;
+}
+
+void SaveBase(
+    const std::filesystem::path& path,
+    const transport::TransportCatalogue& catalogue,
+    const renderer::RenderSettings& render_settings,
+    const transport::TransportRouter& router
+) {
+    std::ofstream output(path, std::ios::binary);
+    if (!output) {
+        throw std::runtime_error("Can't create base file "s + path.string());
+    }
+    WriteBase(output, catalogue, render_settings, router);
+    if (!output) {
+        throw std::runtime_error("Can't write base file "s + path.string());
+    }
+}
+
+std::unique_ptr<Base> LoadBase(const std::filesystem::path& path) {
+    const MappedFile file(path);
+    std::unique_ptr<Base> base = ReadBase(file.begin(), file.end());
+    if (!base) {
+        throw std::runtime_error("Not a transport catalogue base file: "s + path.string());
+    }
+    return base;
+}
+
+std::unique_ptr<Base> CloneBase(const Base& base) {
+    auto clone = std::make_unique<Base>(base.catalogue, base.render_settings);
+    clone->router = std::make_unique<transport::TransportRouter>(*base.router, clone->catalogue);
+    return clone;
+}
+
+} // namespace serialization
@@ -0,0 +1,159 @@
+#pragma once
+
+/*
+ * Сохранение справочника, настроек визуализации и готового маршрутизатора в двоичный файл
+ * и загрузка их обратно. Файл отображается в память только для чтения, из него данные копируются:
+ * справочник заполняется заново, граф собирается из списка рёбер, а таблицы маршрутизатора
+ * читаются целыми массивами, поэтому предподсчёт маршрутов при загрузке не повторяется
+ */
+
+#include "map_renderer.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace serialization {
+
+// Первые байты файла базы и версия формата. Версию нужно увеличивать при любом изменении формата
+inline constexpr std::string_view BASE_FILE_SIGNATURE = "TCBASE";
+inline constexpr uint32_t BASE_FILE_VERSION = 6;
+
+struct SerializationSettings {
+    std::filesystem::path file;
+};
+
+class BinaryWriter {
+public:
+    explicit BinaryWriter(std::ostream& output)
+    : output_(output)
+    {
+
+    }
+
+    template <typename T>
+    void Write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        output_.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    void WriteVector(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        Write(static_cast<uint64_t>(values.size()));
+        output_.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    void WriteString(std::string_view value) {
+        Write(static_cast<uint64_t>(value.size()));
+        output_.write(value.data(), value.size());
+    }
+
+private:
+    std::ostream& output_;
+};
+
+class BinaryReader {
+public:
+    BinaryReader(const char* begin, const char* end)
+    : position_(begin), end_(end)
+    {
+
+    }
+
+    template <typename T>
+    T Read() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value;
+        std::memcpy(&value, Take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    std::vector<T> ReadVector() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const size_t size = Read<uint64_t>();
+        if (size > static_cast<size_t>(end_ - position_) / sizeof(T)) {
+            throw std::runtime_error("Base file is truncated");
+        }
+        std::vector<T> values(size);
+        if (size > 0) {
+            std::memcpy(values.data(), Take(size * sizeof(T)), size * sizeof(T));
+        }
+        return values;
+    }
+
+    std::string ReadString() {
+        const size_t size = Read<uint64_t>();
+        if (size > static_cast<size_t>(end_ - position_)) {
+            throw std::runtime_error("Base file is truncated");
+        }
+        return std::string(Take(size), size);
+    }
+
+private:
+    const char* position_;
+    const char* end_;
+
+    const char* Take(size_t size) {
+        if (size > static_cast<size_t>(end_ - position_)) {
+            throw std::runtime_error("Base file is truncated");
+        }
+        const char* data = position_;
+        position_ += size;
+        return data;
+    }
+};
+
+// Файл, отображённый в память только для чтения
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path& path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const char* begin() const {
+        return data_;
+    }
+    const char* end() const {
+        return data_ + size_;
+    }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// База, загруженная из файла. Маршрутизатор ссылается на остановки и автобусы справочника
+struct Base {
+    transport::TransportCatalogue catalogue;
+    renderer::RenderSettings render_settings;
+    std::unique_ptr<transport::TransportRouter> router;
+};
+
+void SaveBase(
+    const std::filesystem::path& path,
+    const transport::TransportCatalogue& catalogue,
+    const renderer::RenderSettings& render_settings,
+    const transport::TransportRouter& router
+);
+
+std::unique_ptr<Base> LoadBase(const std::filesystem::path& path);
+
+// Независимая копия базы: её можно менять, пока исходную читают другие потоки.
+// Справочник копируется явно, а граф и таблицы маршрутизатора, блоки названий и длины перегонов
+// остаются общими с исходной базой, пока копия их не заменит. Время копирования линейно
+// по числу остановок, автобусов и рёбер графа и не зависит от размера таблиц маршрутизатора
+std::unique_ptr<Base> CloneBase(const Base& base);
+
+} // namespace serialization
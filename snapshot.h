@@ -0,0 +1,171 @@
+#pragma once
+
+/*
+ * Неизменяемые версии данных (например, справочника вместе с маршрутизатором), которые читаются
+ * из многих потоков, пока писатель готовит следующую версию.
+ *
+ * Читатель не берёт блокировок и ничего не ждёт: он отмечает в своём слоте текущую эпоху
+ * и читает атомарный указатель на последнюю версию. Писатель публикует новую версию обменом
+ * указателя, а снятую с публикации удаляет позже, когда ни один читатель не может её видеть
+ * (освобождение по эпохам, как в RCU). Поэтому долгая подготовка версии не задерживает запросы
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace transport {
+
+template <typename Data>
+class SnapshotStore {
+private:
+    struct Snapshot {
+        uint64_t version;
+        std::unique_ptr<const Data> data;
+    };
+
+public:
+    // Доступ читателя к версии. Пока объект жив, версия не удаляется
+    class ReadGuard {
+    public:
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ReadGuard(ReadGuard&& other) noexcept
+        : epoch_(std::exchange(other.epoch_, nullptr)), snapshot_(other.snapshot_)
+        {
+
+        }
+        ReadGuard& operator=(ReadGuard&&) = delete;
+
+        ~ReadGuard() {
+            if (epoch_) {
+                epoch_->store(IDLE_EPOCH, std::memory_order_release);
+            }
+        }
+
+        const Data& operator*() const {
+            return *snapshot_->data;
+        }
+        const Data* operator->() const {
+            return snapshot_->data.get();
+        }
+        uint64_t GetVersion() const {
+            return snapshot_->version;
+        }
+
+    private:
+        friend class SnapshotStore;
+
+        ReadGuard(std::atomic<uint64_t>* epoch, const Snapshot* snapshot)
+        : epoch_(epoch), snapshot_(snapshot)
+        {
+
+        }
+
+        std::atomic<uint64_t>* epoch_;
+        const Snapshot* snapshot_;
+    };
+
+    // reader_count — сколько читателей может читать одновременно. Каждый читатель
+    // пользуется своим номером слота от 0 до reader_count - 1, например номером потока
+    SnapshotStore(std::unique_ptr<const Data> data, size_t reader_count)
+    : reader_slots_(std::make_unique<ReaderSlot[]>(reader_count)), reader_count_(reader_count)
+    {
+        current_.store(new Snapshot{next_version_++, std::move(data)});
+    }
+
+    SnapshotStore(const SnapshotStore&) = delete;
+    SnapshotStore& operator=(const SnapshotStore&) = delete;
+
+    // Все читатели должны завершиться до удаления хранилища
+    ~SnapshotStore() {
+        for (const RetiredSnapshot& retired : retired_) {
+            delete retired.snapshot;
+        }
+        delete current_.load();
+    }
+
+    // Последняя опубликованная версия. Без блокировок; один слот нельзя занимать двумя ReadGuard сразу
+    ReadGuard Read(size_t reader_id) const {
+        using namespace std::literals;
+        if (reader_id >= reader_count_) {
+            throw std::out_of_range("Reader id is out of range"s);
+        }
+        // Эпоха отмечается до чтения указателя: писатель, увидев её, не удалит версию, которую читатель
+        // мог получить. Все операции seq_cst, иначе запись эпохи могла бы переупорядочиться с чтением указателя
+        std::atomic<uint64_t>& epoch = reader_slots_[reader_id].epoch;
+        epoch.store(global_epoch_.load());
+        return ReadGuard(&epoch, current_.load());
+    }
+
+    // Публикует новую версию и возвращает её номер. Писатели упорядочиваются мьютексом,
+    // читатели его не берут. Снятые версии удаляются, как только их перестают читать
+    uint64_t Publish(std::unique_ptr<const Data> data) {
+        std::lock_guard lock(writer_mutex_);
+        const uint64_t version = next_version_++;
+        const Snapshot* old_snapshot = current_.exchange(new Snapshot{version, std::move(data)});
+        // Версию могут видеть только читатели, отметившие эпоху раньше retire_epoch
+        const uint64_t retire_epoch = global_epoch_.fetch_add(1) + 1;
+        retired_.push_back({old_snapshot, retire_epoch});
+        ReclaimLocked();
+        return version;
+    }
+
+    // Удаляет снятые версии, которые уже никто не читает. Никогда не ждёт читателей
+    void Reclaim() {
+        std::lock_guard lock(writer_mutex_);
+        ReclaimLocked();
+    }
+
+    // Сколько снятых версий ещё ждут удаления
+    size_t GetRetiredCount() const {
+        std::lock_guard lock(writer_mutex_);
+        return retired_.size();
+    }
+
+private:
+    static constexpr uint64_t IDLE_EPOCH = std::numeric_limits<uint64_t>::max();
+
+    // Каждый слот на своей кэш-линии, чтобы записи читателей разных потоков не мешали друг другу
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{IDLE_EPOCH};
+    };
+
+    struct RetiredSnapshot {
+        const Snapshot* snapshot;
+        uint64_t epoch;
+    };
+
+    std::atomic<const Snapshot*> current_{nullptr};
+    std::atomic<uint64_t> global_epoch_{0};
+    std::unique_ptr<ReaderSlot[]> reader_slots_;
+    size_t reader_count_;
+
+    mutable std::mutex writer_mutex_;
+    uint64_t next_version_ = 1;
+    std::vector<RetiredSnapshot> retired_;
+
+    void ReclaimLocked() {
+        uint64_t min_reader_epoch = IDLE_EPOCH;
+        for (size_t reader_id = 0; reader_id < reader_count_; ++reader_id) {
+            min_reader_epoch = std::min(min_reader_epoch, reader_slots_[reader_id].epoch.load());
+        }
+        auto kept_end = retired_.begin();
+        for (const RetiredSnapshot& retired : retired_) {
+            if (retired.epoch <= min_reader_epoch) {
+                delete retired.snapshot;
+            } else {
+                *kept_end++ = retired;
+            }
+        }
+        retired_.erase(kept_end, retired_.end());
+    }
+};
+
+} // namespace transport
\ No newline at end of file
@@ -0,0 +1,144 @@
+#define _USE_MATH_DEFINES
+#include "stops_index.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace transport {
+
+namespace {
+
+constexpr double DEG_TO_RAD = M_PI / 180.0;
+constexpr double METRES_PER_DEGREE = geo::EARTH_RADIUS * DEG_TO_RAD;
+// Сетка подбирается так, чтобы в ячейке в среднем было около двух остановок
+constexpr double STOPS_PER_CELL = 2.0;
+
+} // namespace
+
+StopsIndex::StopsIndex(const TransportCatalogue& catalogue)
+: catalogue_(catalogue)
+{
+    const std::span<const geo::Coordinates> coordinates = catalogue.GetStopsCoordinates();
+    if (coordinates.empty()) {
+        return;
+    }
+    geo::Coordinates max_coordinates = coordinates.front();
+    min_coordinates_ = coordinates.front();
+    for (const geo::Coordinates& stop_coordinates : coordinates) {
+        min_coordinates_.lat = std::min(min_coordinates_.lat, stop_coordinates.lat);
+        min_coordinates_.lng = std::min(min_coordinates_.lng, stop_coordinates.lng);
+        max_coordinates.lat = std::max(max_coordinates.lat, stop_coordinates.lat);
+        max_coordinates.lng = std::max(max_coordinates.lng, stop_coordinates.lng);
+    }
+
+    // Ячейки примерно квадратные в метрах
+    const double lat_span = max_coordinates.lat - min_coordinates_.lat;
+    const double lng_span = max_coordinates.lng - min_coordinates_.lng;
+    const double height = lat_span * METRES_PER_DEGREE;
+    const double width = lng_span * METRES_PER_DEGREE
+        * std::cos((min_coordinates_.lat + max_coordinates.lat) / 2 * DEG_TO_RAD);
+    const double cell_count = std::max(1.0, coordinates.size() / STOPS_PER_CELL);
+    const double cell_side = std::sqrt(std::max(height * width, 1.0) / cell_count);
+    rows_ = std::clamp<size_t>(static_cast<size_t>(std::ceil(height / cell_side)), 1, coordinates.size());
+    cols_ = std::clamp<size_t>(static_cast<size_t>(std::ceil(width / cell_side)), 1, coordinates.size());
+    cell_lat_size_ = lat_span > 0 ? lat_span / rows_ : 1.0;
+    cell_lng_size_ = lng_span > 0 ? lng_span / cols_ : 1.0;
+
+    // Раскладка остановок по ячейкам подсчётом
+    std::vector<size_t> stop_cells(coordinates.size());
+    cell_offsets_.assign(rows_ * cols_ + 1, 0);
+    for (StopId stop_id = 0; stop_id < coordinates.size(); ++stop_id) {
+        if (catalogue.IsStopRemoved(stop_id)) {
+            continue;
+        }
+        stop_cells[stop_id] = GetRow(coordinates[stop_id].lat) * cols_ + GetCol(coordinates[stop_id].lng);
+        ++cell_offsets_[stop_cells[stop_id] + 1];
+    }
+    for (size_t cell = 0; cell < rows_ * cols_; ++cell) {
+        cell_offsets_[cell + 1] += cell_offsets_[cell];
+    }
+    cell_stops_.resize(cell_offsets_.back());
+    std::vector<uint32_t> cell_positions(cell_offsets_.begin(), cell_offsets_.end() - 1);
+    for (StopId stop_id = 0; stop_id < coordinates.size(); ++stop_id) {
+        if (catalogue.IsStopRemoved(stop_id)) {
+            continue;
+        }
+        cell_stops_[cell_positions[stop_cells[stop_id]]++] = stop_id;
+    }
+    const std::span<const geo::PreparedCoordinates> prepared_coordinates = catalogue.GetStopsPreparedCoordinates();
+    cell_coordinates_.reserve(cell_stops_.size());
+    for (const StopId stop_id : cell_stops_) {
+        cell_coordinates_.push_back(prepared_coordinates[stop_id]);
+    }
+}
+
+size_t StopsIndex::GetRow(double lat) const {
+    const double row = std::floor((lat - min_coordinates_.lat) / cell_lat_size_);
+    return static_cast<size_t>(std::clamp(row, 0.0, static_cast<double>(rows_ - 1)));
+}
+
+size_t StopsIndex::GetCol(double lng) const {
+    const double col = std::floor((lng - min_coordinates_.lng) / cell_lng_size_);
+    return static_cast<size_t>(std::clamp(col, 0.0, static_cast<double>(cols_ - 1)));
+}
+
+std::vector<NearbyStop> StopsIndex::FindStopsWithin(geo::Coordinates point, double radius) const {
+    std::vector<NearbyStop> nearby_stops;
+    if (cell_stops_.empty() || !(radius >= 0)) {
+        return nearby_stops;
+    }
+
+    // Прямоугольник по широте и долготе, в который целиком попадает круг радиуса radius
+    const double angular_radius = radius / geo::EARTH_RADIUS;
+    const double lat_delta = angular_radius / DEG_TO_RAD;
+    double lng_delta = 360.0;
+    const double cos_lat = std::cos(point.lat * DEG_TO_RAD);
+    if (angular_radius < M_PI / 2 && std::sin(angular_radius) < cos_lat) {
+        lng_delta = std::asin(std::sin(angular_radius) / cos_lat) / DEG_TO_RAD;
+    }
+    const size_t row_begin = GetRow(point.lat - lat_delta);
+    const size_t row_end = GetRow(point.lat + lat_delta) + 1;
+    const size_t col_begin = GetCol(point.lng - lng_delta);
+    const size_t col_end = GetCol(point.lng + lng_delta) + 1;
+
+    const geo::PreparedCoordinates prepared_point = geo::PrepareCoordinates(point);
+    const std::span<const geo::PreparedCoordinates> cell_coordinates = cell_coordinates_;
+    std::vector<double> distances;
+    for (size_t row = row_begin; row < row_end; ++row) {
+        const uint32_t begin = cell_offsets_[row * cols_ + col_begin];
+        const uint32_t end = cell_offsets_[row * cols_ + col_end];
+        distances.resize(end - begin);
+        geo::ComputeDistances(prepared_point, cell_coordinates.subspan(begin, end - begin), distances);
+        for (uint32_t position = begin; position < end; ++position) {
+            if (distances[position - begin] <= radius) {
+                nearby_stops.push_back({catalogue_.GetStop(cell_stops_[position]), distances[position - begin]});
+            }
+        }
+    }
+    std::sort(nearby_stops.begin(), nearby_stops.end(), [](const NearbyStop& lhs, const NearbyStop& rhs) {
+        return lhs.distance < rhs.distance
+            || (lhs.distance == rhs.distance && lhs.stop->stop_name < rhs.stop->stop_name);
+    });
+    return nearby_stops;
+}
+
+std::vector<NearbyStop> StopsIndex::FindNearestStops(geo::Coordinates point, size_t count, double max_radius) const {
+    if (count == 0 || cell_stops_.empty()) {
+        return {};
+    }
+    // Радиус поиска удваивается, пока в круг не попадёт count остановок. Остановки вне круга
+    // дальше любой остановки внутри, поэтому первые count найденных — искомые
+    const double max_distance = M_PI * geo::EARTH_RADIUS;
+    double radius = std::max(1.0, std::min(cell_lat_size_ * METRES_PER_DEGREE, max_distance));
+    while (true) {
+        const double cur_radius = std::min(radius, max_radius);
+        std::vector<NearbyStop> nearby_stops = FindStopsWithin(point, cur_radius);
+        if (nearby_stops.size() >= count || cur_radius >= max_radius || radius >= max_distance) {
+            nearby_stops.resize(std::min(nearby_stops.size(), count));
+            return nearby_stops;
+        }
+        radius *= 2;
+    }
+}
+
+} // namespace transport
\ No newline at end of file
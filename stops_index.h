@@ -0,0 +1,51 @@
+#pragma once
+
+/*
+ * Пространственный индекс остановок: равномерная сетка по широте и долготе.
+ * Остановки каждой ячейки лежат подряд в одном массиве, поэтому поиск просматривает
+ * лишь несколько ячеек около точки, а не все остановки справочника
+ */
+
+#include "domain.h"
+#include "geo.h"
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace transport {
+
+class StopsIndex {
+public:
+    // Индекс строится по остановкам, которые есть в справочнике на момент создания
+    explicit StopsIndex(const TransportCatalogue& catalogue);
+
+    // Остановки не дальше radius метров от точки, по возрастанию расстояния
+    std::vector<NearbyStop> FindStopsWithin(geo::Coordinates point, double radius) const;
+
+    // Не более count ближайших к точке остановок не дальше max_radius метров, по возрастанию расстояния
+    std::vector<NearbyStop> FindNearestStops(
+        geo::Coordinates point,
+        size_t count,
+        double max_radius = std::numeric_limits<double>::infinity()
+    ) const;
+
+private:
+    const TransportCatalogue& catalogue_;
+    geo::Coordinates min_coordinates_{0.0, 0.0};
+    double cell_lat_size_ = 1.0; // Размеры ячейки в градусах
+    double cell_lng_size_ = 1.0;
+    size_t rows_ = 0;
+    size_t cols_ = 0;
+    std::vector<uint32_t> cell_offsets_; // Остановки ячейки i — cell_stops_[cell_offsets_[i], cell_offsets_[i + 1])
+    std::vector<StopId> cell_stops_;
+    // Координаты остановок в том же порядке, что и cell_stops_: ячейки одной строки сетки лежат подряд,
+    // поэтому расстояния до всех кандидатов строки считаются одним пакетом
+    std::vector<geo::PreparedCoordinates> cell_coordinates_;
+
+    size_t GetRow(double lat) const;
+    size_t GetCol(double lng) const;
+};
+
+} // namespace transport
\ No newline at end of file
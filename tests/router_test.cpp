@@ -0,0 +1,174 @@
+#include <iostream>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "router.h"
+
+using namespace std::literals;
+
+namespace {
+
+using Graph = graph::DirectedWeightedGraph<double>;
+using Router = graph::Router<double>;
+
+void Check(bool condition, const std::string& message) {
+    if (!condition) {
+        throw std::runtime_error(message);
+    }
+}
+
+// Случайный граф с целыми весами от 0 до max_weight: суммы весов точны, поэтому веса маршрутов
+// сравниваются на равенство. При малом max_weight много маршрутов равного веса, при большом их
+// практически нет. Часть вершин получает много входящих рёбер, как пересадочные остановки
+Graph MakeRandomGraph(size_t vertex_count, size_t edge_count, unsigned seed, int max_weight = 20) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<size_t> vertex_distribution(0, vertex_count - 1);
+    std::uniform_int_distribution<size_t> hub_distribution(0, vertex_count / 16);
+    std::uniform_int_distribution<int> weight_distribution(0, max_weight);
+    Graph graph(vertex_count);
+    for (size_t i = 0; i < edge_count; ++i) {
+        const graph::VertexId from = vertex_distribution(generator);
+        const graph::VertexId to = i % 3 == 0 ? hub_distribution(generator) : vertex_distribution(generator);
+        graph.AddEdge({from, to, static_cast<double>(weight_distribution(generator))});
+    }
+    return graph;
+}
+
+// Путь должен начинаться в from, заканчиваться в to, идти по смежным рёбрам и весить weight
+void CheckPath(const Graph& graph, graph::VertexId from, graph::VertexId to, const Router::RouteInfo& route,
+               const std::string& context) {
+    graph::VertexId vertex = from;
+    double weight = 0;
+    for (const graph::EdgeId edge_id : route.edges) {
+        const graph::Edge<double>& edge = graph.GetEdge(edge_id);
+        Check(edge.from == vertex, context + ": path is not connected"s);
+        vertex = edge.to;
+        weight += edge.weight;
+    }
+    Check(vertex == to, context + ": path ends in a wrong vertex"s);
+    Check(weight == route.weight, context + ": path weight differs from route weight"s);
+}
+
+// CSR-представление перечисляет те же исходящие рёбра вершин в том же порядке, что и исходный граф
+void TestFrozenGraphIncidentEdges() {
+    const Graph graph = MakeRandomGraph(200, 1000, 7);
+    const graph::FrozenDirectedWeightedGraph<double> frozen_graph(graph);
+    Check(frozen_graph.GetVertexCount() == graph.GetVertexCount(), "frozen graph vertex count differs"s);
+    Check(frozen_graph.GetEdgeCount() == graph.GetEdgeCount(), "frozen graph edge count differs"s);
+    for (graph::VertexId vertex = 0; vertex < graph.GetVertexCount(); ++vertex) {
+        const auto incident_edges = graph.GetIncidentEdges(vertex);
+        const auto frozen_incident_edges = frozen_graph.GetIncidentEdges(vertex);
+        const std::vector<graph::EdgeId> expected(incident_edges.begin(), incident_edges.end());
+        const std::vector<graph::EdgeId> edges(frozen_incident_edges.begin(), frozen_incident_edges.end());
+        Check(edges == expected, "frozen graph incident edges differ at vertex "s + std::to_string(vertex));
+        for (size_t position = frozen_graph.GetEdgesBegin(vertex); position < frozen_graph.GetEdgesEnd(vertex); ++position) {
+            const graph::Edge<double>& edge = graph.GetEdge(frozen_graph.GetEdgeId(position));
+            Check(edge.to == frozen_graph.GetTarget(position) && edge.weight == frozen_graph.GetWeight(position),
+                  "frozen graph edge differs at vertex "s + std::to_string(vertex));
+        }
+    }
+}
+
+// Многопоточный предподсчёт всех пар на графе с множеством маршрутов равного веса выбирает те же
+// маршруты, что и однопоточный: совпадают веса и списки рёбер, то есть и выбор prev_edge
+void TestParallelAllPairsMatchesSingleThreaded() {
+    for (const unsigned seed : {4u, 5u}) {
+        const Graph graph = MakeRandomGraph(300, 1500, seed);
+        const Router expected_router(graph, graph::RouterMode::ALL_PAIRS);
+        for (const size_t thread_count : {2u, 4u}) {
+            const Router router(graph, graph::RouterMode::ALL_PAIRS, thread_count);
+            for (graph::VertexId from = 0; from < graph.GetVertexCount(); ++from) {
+                for (graph::VertexId to = 0; to < graph.GetVertexCount(); ++to) {
+                    const std::string context = "threads "s + std::to_string(thread_count) + " seed "s
+                        + std::to_string(seed) + " route "s + std::to_string(from) + " -> "s + std::to_string(to);
+                    const std::optional<Router::RouteInfo> expected = expected_router.BuildRoute(from, to);
+                    const std::optional<Router::RouteInfo> route = router.BuildRoute(from, to);
+                    Check(route.has_value() == expected.has_value(), context + ": route presence differs"s);
+                    if (route) {
+                        Check(route->weight == expected->weight, context + ": route weight differs"s);
+                        Check(route->edges == expected->edges, context + ": route edges differ"s);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Блочное ядро на графе из нескольких блоков 64×64 в одном и нескольких потоках.
+// Без маршрутов равного веса кратчайший путь единственный, и списки рёбер совпадают с ALL_PAIRS.
+// При равных весах блочный порядок релаксации может выбрать другой путь того же веса, поэтому
+// сравниваются веса, корректность пути и совпадение списков рёбер между числом потоков
+void TestBlockedAllPairsMatchesAllPairs() {
+    for (const unsigned seed : {6u, 7u}) {
+        for (const int max_weight : {20, 1 << 30}) {
+            const bool has_ties = max_weight == 20;
+            const Graph graph = MakeRandomGraph(300, 1500, seed, max_weight);
+            const Router all_pairs(graph, graph::RouterMode::ALL_PAIRS);
+            const Router blocked(graph, graph::RouterMode::ALL_PAIRS_BLOCKED);
+            const Router parallel_blocked(graph, graph::RouterMode::ALL_PAIRS_BLOCKED, 4);
+            for (graph::VertexId from = 0; from < graph.GetVertexCount(); ++from) {
+                for (graph::VertexId to = 0; to < graph.GetVertexCount(); ++to) {
+                    const std::string context = "max_weight "s + std::to_string(max_weight) + " seed "s
+                        + std::to_string(seed) + " route "s + std::to_string(from) + " -> "s + std::to_string(to);
+                    const std::optional<Router::RouteInfo> expected = all_pairs.BuildRoute(from, to);
+                    const std::optional<Router::RouteInfo> route = blocked.BuildRoute(from, to);
+                    const std::optional<Router::RouteInfo> parallel_route = parallel_blocked.BuildRoute(from, to);
+                    Check(route.has_value() == expected.has_value(), context + ": route presence differs"s);
+                    Check(parallel_route.has_value() == expected.has_value(), context + ": route presence differs"s);
+                    if (!route) {
+                        continue;
+                    }
+                    Check(route->weight == expected->weight, context + ": route weight differs"s);
+                    Check(parallel_route->weight == route->weight && parallel_route->edges == route->edges,
+                          context + ": parallel blocked route differs"s);
+                    if (has_ties) {
+                        CheckPath(graph, from, to, *route, context);
+                    } else {
+                        Check(route->edges == expected->edges, context + ": route edges differ"s);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Иерархии сжатия, построенные в нескольких потоках, дают те же веса, что и предподсчёт всех пар
+void TestContractionHierarchiesMatchAllPairs() {
+    for (const unsigned seed : {1u, 2u, 3u}) {
+        const Graph graph = MakeRandomGraph(300, 2400, seed);
+        const Router all_pairs(graph, graph::RouterMode::ALL_PAIRS);
+        const Router hierarchies(graph, graph::RouterMode::CONTRACTION_HIERARCHIES, 4);
+        for (graph::VertexId from = 0; from < graph.GetVertexCount(); ++from) {
+            for (graph::VertexId to = 0; to < graph.GetVertexCount(); ++to) {
+                const std::string context = "seed "s + std::to_string(seed) + " route "s + std::to_string(from)
+                    + " -> "s + std::to_string(to);
+                const std::optional<Router::RouteInfo> expected = all_pairs.BuildRoute(from, to);
+                const std::optional<Router::RouteInfo> route = hierarchies.BuildRoute(from, to);
+                Check(route.has_value() == expected.has_value(), context + ": route presence differs"s);
+                if (route) {
+                    Check(route->weight == expected->weight, context + ": route weight differs"s);
+                    CheckPath(graph, from, to, *route, context);
+                }
+            }
+        }
+    }
+}
+
+}  // namespace
+
+int main() {
+    try {
+        TestFrozenGraphIncidentEdges();
+        TestParallelAllPairsMatchesSingleThreaded();
+        TestBlockedAllPairsMatchesAllPairs();
+        TestContractionHierarchiesMatchAllPairs();
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: "sv << e.what() << std::endl;
+        return 1;
+    }
+    std::cerr << "router_test OK"sv << std::endl;
+    return 0;
+}
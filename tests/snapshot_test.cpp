@@ -0,0 +1,329 @@
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "serialization.h"
+#include "snapshot.h"
+
+using namespace std::literals;
+
+namespace {
+
+void Check(bool condition, const std::string& message) {
+    if (!condition) {
+        throw std::runtime_error(message);
+    }
+}
+
+std::atomic<int> live_data_count = 0;
+
+// Версия данных: все элементы items равны value, а value — номеру версии в хранилище.
+// Если читатель увидит частично записанную или уже удалённую версию, равенство нарушится
+struct Data {
+    explicit Data(uint64_t version)
+    : value(version), items(64, version)
+    {
+        ++live_data_count;
+    }
+
+    ~Data() {
+        --live_data_count;
+        items.assign(items.size(), 0);
+    }
+
+    uint64_t value;
+    std::vector<uint64_t> items;
+};
+
+using Store = transport::SnapshotStore<Data>;
+
+// Версия, которую держит читатель, не удаляется при публикации новой, а удаляется после освобождения
+void TestHeldSnapshotSurvivesPublish() {
+    Store store(std::make_unique<const Data>(1), 2);
+    {
+        const auto guard = store.Read(0);
+        Check(store.Publish(std::make_unique<const Data>(2)) == 2, "unexpected published version"s);
+        Check(store.GetRetiredCount() == 1, "held snapshot was reclaimed"s);
+        Check(guard->value == 1 && guard.GetVersion() == 1, "held snapshot changed"s);
+        Check(store.Read(1)->value == 2, "new snapshot is not visible"s);
+    }
+    store.Reclaim();
+    Check(store.GetRetiredCount() == 0, "released snapshot was not reclaimed"s);
+    Check(live_data_count == 1, "wrong number of live snapshots"s);
+}
+
+// Читатели без остановки читают версии, пока писатель публикует новые. Каждая прочитанная версия
+// должна быть целой, а номера версий у одного читателя — не убывать
+void TestConcurrentReadersAndWriter() {
+    static constexpr size_t READER_COUNT = 4;
+    static constexpr uint64_t VERSION_COUNT = 2000;
+    {
+        Store store(std::make_unique<const Data>(1), READER_COUNT);
+        std::atomic<bool> is_writer_done = false;
+        std::vector<std::string> reader_errors(READER_COUNT);
+
+        auto read_snapshots = [&](size_t reader_id) {
+            uint64_t last_version = 0;
+            size_t read_count = 0;
+            while (!is_writer_done.load() || read_count < 1000) {
+                const auto guard = store.Read(reader_id);
+                if (guard.GetVersion() < last_version) {
+                    reader_errors[reader_id] = "snapshot version went back"s;
+                    return;
+                }
+                last_version = guard.GetVersion();
+                for (const uint64_t item : guard->items) {
+                    if (item != guard->value || guard->value != last_version) {
+                        reader_errors[reader_id] = "snapshot is torn or reclaimed while read"s;
+                        return;
+                    }
+                }
+                // Иногда версия держится дольше, чтобы писатель успел снять её с публикации
+                if (++read_count % 64 == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        };
+
+        std::vector<std::thread> readers;
+        for (size_t reader_id = 0; reader_id < READER_COUNT; ++reader_id) {
+            readers.emplace_back(read_snapshots, reader_id);
+        }
+        for (uint64_t version = 2; version <= VERSION_COUNT; ++version) {
+            Check(store.Publish(std::make_unique<const Data>(version)) == version, "unexpected published version"s);
+        }
+        is_writer_done = true;
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+        for (const std::string& error : reader_errors) {
+            Check(error.empty(), error);
+        }
+
+        Check(store.Read(0)->value == VERSION_COUNT, "last snapshot is not visible"s);
+        store.Reclaim();
+        Check(store.GetRetiredCount() == 0, "idle readers block reclamation"s);
+        Check(live_data_count == 1, "retired snapshots leaked"s);
+    }
+    Check(live_data_count == 0, "store leaked snapshots"s);
+}
+
+// Поочерёдная работа писателя и читателей: писатель публикует следующую версию, только когда каждый
+// читатель взял ReadGuard на текущую, а читатель держит его до следующей публикации. Так каждую версию
+// читает каждый читатель, и каждая удерживаемая версия переживает публикацию новой
+class Lockstep {
+public:
+    explicit Lockstep(size_t reader_count)
+    : seen_versions_(reader_count)
+    {
+
+    }
+
+    // Читатель взял version и ждёт публикации следующей версии или окончания записи
+    void HoldUntilNewer(size_t reader_id, uint64_t version) {
+        seen_versions_[reader_id] = version;
+        while (published_version_.load() <= version && !is_writer_done_.load()) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Читатель завершился с ошибкой, писатель его больше не ждёт
+    void Leave(size_t reader_id) {
+        seen_versions_[reader_id] = std::numeric_limits<uint64_t>::max();
+    }
+
+    // Писатель опубликовал version и ждёт, пока её возьмут все читатели
+    void PublishAndWait(uint64_t version) {
+        published_version_ = version;
+        for (const std::atomic<uint64_t>& seen_version : seen_versions_) {
+            while (seen_version.load() < version) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void Finish() {
+        is_writer_done_ = true;
+    }
+
+    bool IsWriterDone() const {
+        return is_writer_done_.load();
+    }
+
+private:
+    std::vector<std::atomic<uint64_t>> seen_versions_;
+    std::atomic<uint64_t> published_version_ = 0;
+    std::atomic<bool> is_writer_done_ = false;
+};
+
+// Каждый читатель держит ReadGuard, пока писатель публикует хотя бы одну новую версию, и после этого
+// проверяет, что удерживаемая версия цела. Снятые версии при этом ждут удаления, а не удаляются
+void TestReadersHoldGuardsAcrossPublishes() {
+    static constexpr size_t READER_COUNT = 4;
+    static constexpr uint64_t VERSION_COUNT = 300;
+    {
+        Store store(std::make_unique<const Data>(1), READER_COUNT);
+        Lockstep lockstep(READER_COUNT);
+        std::vector<std::string> reader_errors(READER_COUNT);
+
+        auto hold_snapshots = [&](size_t reader_id) {
+            while (!lockstep.IsWriterDone()) {
+                const auto guard = store.Read(reader_id);
+                const uint64_t version = guard.GetVersion();
+                lockstep.HoldUntilNewer(reader_id, version);
+                for (const uint64_t item : guard->items) {
+                    if (item != version || guard->value != version) {
+                        reader_errors[reader_id] = "held snapshot is torn or reclaimed"s;
+                        lockstep.Leave(reader_id);
+                        return;
+                    }
+                }
+            }
+        };
+
+        std::vector<std::thread> readers;
+        for (size_t reader_id = 0; reader_id < READER_COUNT; ++reader_id) {
+            readers.emplace_back(hold_snapshots, reader_id);
+        }
+        lockstep.PublishAndWait(1);
+        for (uint64_t version = 2; version <= VERSION_COUNT; ++version) {
+            Check(store.Publish(std::make_unique<const Data>(version)) == version, "unexpected published version"s);
+            // Предыдущую версию ещё держат все читатели
+            Check(store.GetRetiredCount() >= 1, "held snapshot was reclaimed"s);
+            lockstep.PublishAndWait(version);
+        }
+        lockstep.Finish();
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+        for (const std::string& error : reader_errors) {
+            Check(error.empty(), error);
+        }
+        store.Reclaim();
+        Check(store.GetRetiredCount() == 0, "released snapshots were not reclaimed"s);
+        Check(live_data_count == 1, "retired snapshots leaked"s);
+    }
+    Check(live_data_count == 0, "store leaked snapshots"s);
+}
+
+// Как в process_requests: писатель копирует последнюю версию базы через CloneBase, меняет маршрут автобуса,
+// обновляет маршрутизатор и публикует копию, а читатели в это время ищут маршруты по удерживаемым версиям.
+// Копии делят с исходной базой граф, таблицы маршрутизатора и длины перегонов, поэтому тест под
+// ThreadSanitizer проверяет, что обновление копии не меняет общие части. В нечётных версиях автобус
+// идёт A - B - C, в чётных — A - C
+void TestBaseReadersAndUpdatingWriter(graph::RouterMode router_mode, const std::string& context) {
+    static constexpr size_t READER_COUNT = 3;
+    static constexpr uint64_t VERSION_COUNT = 60;
+    using BaseStore = transport::SnapshotStore<serialization::Base>;
+
+    auto base = std::make_unique<serialization::Base>();
+    transport::TransportCatalogue& catalogue = base->catalogue;
+    catalogue.AddStop({"A"sv, {55.60, 37.60}});
+    catalogue.AddStop({"B"sv, {55.61, 37.61}});
+    catalogue.AddStop({"C"sv, {55.62, 37.60}});
+    catalogue.SetDistanceBetweenStops(catalogue.FindStop("A"sv), catalogue.FindStop("B"sv), 1000);
+    catalogue.SetDistanceBetweenStops(catalogue.FindStop("B"sv), catalogue.FindStop("C"sv), 2000);
+    catalogue.SetDistanceBetweenStops(catalogue.FindStop("A"sv), catalogue.FindStop("C"sv), 6000);
+    catalogue.AddBus({"1"sv, {catalogue.FindStop("A"sv), catalogue.FindStop("B"sv), catalogue.FindStop("C"sv)}, false});
+    catalogue.Freeze();
+    transport::TransportRouteSettings settings;
+    settings.bus_wait_time = 6;
+    settings.bus_velocity = 60; // 1000 метров в минуту
+    settings.router_mode = router_mode;
+    base->router = std::make_unique<transport::TransportRouter>(settings, catalogue);
+
+    // Слот READER_COUNT — писателя, который читает последнюю версию для копирования
+    BaseStore store(std::move(base), READER_COUNT + 1);
+    Lockstep lockstep(READER_COUNT);
+    std::vector<std::string> reader_errors(READER_COUNT);
+
+    auto read_routes = [&](size_t reader_id) {
+        auto fail = [&](const std::string& error) {
+            reader_errors[reader_id] = error;
+            lockstep.Leave(reader_id);
+        };
+        while (!lockstep.IsWriterDone()) {
+            const auto guard = store.Read(reader_id);
+            const uint64_t version = guard.GetVersion();
+            const transport::TransportCatalogue& snapshot_catalogue = guard->catalogue;
+            const transport::Stop* a = snapshot_catalogue.FindStop("A"sv);
+            const transport::Stop* c = snapshot_catalogue.FindStop("C"sv);
+            const double expected_time = version % 2 == 1 ? 9.0 : 12.0;
+            const int expected_length = version % 2 == 1 ? 6000 : 12000;
+            lockstep.HoldUntilNewer(reader_id, version);
+            const auto route = guard->router->FindOptimalRoute(a, c);
+            if (!route || route->GetTotalTime() != expected_time) {
+                fail("wrong route time in version "s + std::to_string(version));
+                return;
+            }
+            const transport::Bus* bus = snapshot_catalogue.FindBus("1"sv);
+            if (snapshot_catalogue.GetBusInfo(bus).route_length != expected_length) {
+                fail("wrong bus length in version "s + std::to_string(version));
+                return;
+            }
+            bool is_own_objects = true;
+            route->ForEachItem([&](const transport::TransportRouter::EdgeInfo& edge_info) {
+                if (const auto* wait_info = std::get_if<transport::TransportRouter::WaitEdgeInfo>(&edge_info)) {
+                    is_own_objects = is_own_objects && wait_info->stop == a;
+                } else {
+                    is_own_objects = is_own_objects && std::get<transport::TransportRouter::BusEdgeInfo>(edge_info).bus == bus;
+                }
+            });
+            if (!is_own_objects) {
+                fail("route refers to another version in version "s + std::to_string(version));
+                return;
+            }
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for (size_t reader_id = 0; reader_id < READER_COUNT; ++reader_id) {
+        readers.emplace_back(read_routes, reader_id);
+    }
+    lockstep.PublishAndWait(1);
+    for (uint64_t version = 2; version <= VERSION_COUNT; ++version) {
+        std::unique_ptr<serialization::Base> next_base = serialization::CloneBase(*store.Read(READER_COUNT));
+        transport::TransportCatalogue& next_catalogue = next_base->catalogue;
+        std::vector<const transport::Stop*> stops = {next_catalogue.FindStop("A"sv), next_catalogue.FindStop("C"sv)};
+        if (version % 2 == 1) {
+            stops.insert(stops.begin() + 1, next_catalogue.FindStop("B"sv));
+        }
+        next_catalogue.UpdateBus({"1"sv, std::move(stops), false});
+        next_base->router->Update(next_catalogue, next_catalogue.TakeChangedBuses());
+        Check(store.Publish(std::move(next_base)) == version, context + ": unexpected published version"s);
+        lockstep.PublishAndWait(version);
+    }
+    lockstep.Finish();
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    for (const std::string& error : reader_errors) {
+        Check(error.empty(), context + ": "s + error);
+    }
+}
+
+}  // namespace
+
+int main() {
+    try {
+        TestHeldSnapshotSurvivesPublish();
+        Check(live_data_count == 0, "store leaked snapshots"s);
+        TestConcurrentReadersAndWriter();
+        TestReadersHoldGuardsAcrossPublishes();
+        TestBaseReadersAndUpdatingWriter(graph::RouterMode::ALL_PAIRS, "all_pairs"s);
+        TestBaseReadersAndUpdatingWriter(graph::RouterMode::ALL_PAIRS_BLOCKED, "all_pairs_blocked"s);
+        TestBaseReadersAndUpdatingWriter(graph::RouterMode::DIJKSTRA, "dijkstra"s);
+        TestBaseReadersAndUpdatingWriter(graph::RouterMode::CONTRACTION_HIERARCHIES, "contraction_hierarchies"s);
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: "sv << e.what() << std::endl;
+        return 1;
+    }
+    std::cerr << "snapshot_test OK"sv << std::endl;
+    return 0;
+}
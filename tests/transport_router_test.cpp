@@ -0,0 +1,209 @@
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+using namespace std::literals;
+using namespace transport;
+
+namespace {
+
+void Check(bool condition, const std::string& message) {
+    if (!condition) {
+        throw std::runtime_error(message);
+    }
+}
+
+// Ожидаемый элемент маршрута: ожидание (is_wait) или поездка на span_count перегонов
+struct ExpectedItem {
+    bool is_wait;
+    size_t span_count;
+    double time;
+};
+
+void CheckRoute(
+    const TransportRouter& router,
+    const Stop* stop_from,
+    const Stop* stop_to,
+    double total_time,
+    const std::vector<ExpectedItem>& expected_items,
+    const std::string& context
+) {
+    const std::optional<TransportRouter::RouteView> route = router.FindOptimalRoute(stop_from, stop_to);
+    Check(route.has_value(), context + ": route not found"s);
+    Check(std::abs(route->GetTotalTime() - total_time) < 1e-9, context + ": wrong total_time"s);
+
+    std::vector<ExpectedItem> items;
+    route->ForEachItem([&items](const TransportRouter::EdgeInfo& edge_info) {
+        if (const auto* wait_info = std::get_if<TransportRouter::WaitEdgeInfo>(&edge_info)) {
+            items.push_back({true, 0, wait_info->bus_wait_time});
+        } else {
+            const auto& bus_info = std::get<TransportRouter::BusEdgeInfo>(edge_info);
+            items.push_back({false, bus_info.span_count, bus_info.time});
+        }
+    });
+    Check(items.size() == expected_items.size(), context + ": wrong item count"s);
+    for (size_t i = 0; i < items.size(); ++i) {
+        Check(items[i].is_wait == expected_items[i].is_wait, context + ": wrong item type"s);
+        Check(items[i].span_count == expected_items[i].span_count, context + ": wrong span_count"s);
+        Check(std::abs(items[i].time - expected_items[i].time) < 1e-9, context + ": wrong item time"s);
+    }
+}
+
+// Некольцевой маршрут A - B - C, расстояния по дорогам в обратную сторону больше прямых.
+// Время элемента Bus в обратную сторону должно считаться по обратным расстояниям, как и вес ребра
+void TestAsymmetricRoadDistances(BusGraphModel bus_graph_model, graph::RouterMode router_mode, const std::string& context) {
+    TransportCatalogue catalogue;
+    catalogue.AddStop({"A"sv, {55.60, 37.60}});
+    catalogue.AddStop({"B"sv, {55.61, 37.61}});
+    catalogue.AddStop({"C"sv, {55.62, 37.62}});
+    const Stop* a = catalogue.FindStop("A"sv);
+    const Stop* b = catalogue.FindStop("B"sv);
+    const Stop* c = catalogue.FindStop("C"sv);
+    catalogue.SetDistanceBetweenStops(a, b, 1000);
+    catalogue.SetDistanceBetweenStops(b, a, 2000);
+    catalogue.SetDistanceBetweenStops(b, c, 1000);
+    catalogue.SetDistanceBetweenStops(c, b, 4000);
+    catalogue.AddBus({"1"sv, {a, b, c}, false});
+    catalogue.Freeze();
+
+    TransportRouteSettings settings;
+    settings.bus_wait_time = 6;
+    settings.bus_velocity = 60; // 1000 метров в минуту
+    settings.bus_graph_model = bus_graph_model;
+    settings.router_mode = router_mode;
+    const TransportRouter router(settings, catalogue);
+
+    CheckRoute(router, a, c, 8.0, {{true, 0, 6.0}, {false, 2, 2.0}}, context + " A -> C"s);
+    CheckRoute(router, c, a, 12.0, {{true, 0, 6.0}, {false, 2, 6.0}}, context + " C -> A"s);
+    CheckRoute(router, c, b, 10.0, {{true, 0, 6.0}, {false, 1, 4.0}}, context + " C -> B"s);
+}
+
+// Маршрутизатор после нескольких обновлений отвечает так же, как построенный заново по итоговому справочнику
+void TestUpdateMatchesRebuild(BusGraphModel bus_graph_model, graph::RouterMode router_mode, const std::string& context) {
+    TransportCatalogue catalogue;
+    catalogue.AddStop({"A"sv, {55.60, 37.60}});
+    catalogue.AddStop({"B"sv, {55.61, 37.61}});
+    catalogue.AddStop({"C"sv, {55.62, 37.60}});
+    catalogue.AddStop({"D"sv, {55.61, 37.59}});
+    const Stop* a = catalogue.FindStop("A"sv);
+    const Stop* b = catalogue.FindStop("B"sv);
+    const Stop* c = catalogue.FindStop("C"sv);
+    const Stop* d = catalogue.FindStop("D"sv);
+    catalogue.SetDistanceBetweenStops(a, b, 1000);
+    catalogue.SetDistanceBetweenStops(b, c, 2000);
+    catalogue.SetDistanceBetweenStops(c, d, 1500);
+    catalogue.SetDistanceBetweenStops(d, a, 3000);
+    catalogue.AddBus({"1"sv, {a, b, c}, false});
+    catalogue.AddBus({"2"sv, {c, d, a, c}, true});
+    catalogue.Freeze();
+
+    TransportRouteSettings settings;
+    settings.bus_wait_time = 6;
+    settings.bus_velocity = 60;
+    settings.bus_graph_model = bus_graph_model;
+    settings.router_mode = router_mode;
+    TransportRouter router(settings, catalogue);
+
+    const std::vector<std::vector<const Stop*>> routes = {{a, d, c}, {b, c, d}, {a, b, c, d}};
+    for (const std::vector<const Stop*>& stops : routes) {
+        catalogue.UpdateBus({"1"sv, stops, false});
+        router.Update(catalogue, catalogue.TakeChangedBuses());
+    }
+    catalogue.RemoveBus(catalogue.FindBus("2"sv));
+    router.Update(catalogue, catalogue.TakeChangedBuses());
+
+    const TransportRouter rebuilt_router(settings, catalogue);
+    for (const Stop* stop_from : {a, b, c, d}) {
+        for (const Stop* stop_to : {a, b, c, d}) {
+            const auto route = router.FindOptimalRoute(stop_from, stop_to);
+            const auto rebuilt_route = rebuilt_router.FindOptimalRoute(stop_from, stop_to);
+            const std::string pair_context = context + " "s + std::string(stop_from->stop_name) + " -> "s
+                + std::string(stop_to->stop_name);
+            Check(route.has_value() == rebuilt_route.has_value(), pair_context + ": route presence differs"s);
+            if (route) {
+                Check(std::abs(route->GetTotalTime() - rebuilt_route->GetTotalTime()) < 1e-9,
+                      pair_context + ": total_time differs"s);
+            }
+        }
+    }
+}
+
+// Копия справочника и маршрутизатора меняется независимо от исходных: исходный маршрутизатор
+// отвечает по-прежнему, а копия — как построенный заново по изменённой копии справочника.
+// Остановки и автобусы в ответах копии — объекты её справочника
+void TestCopyIsIndependent(BusGraphModel bus_graph_model, graph::RouterMode router_mode, const std::string& context) {
+    TransportCatalogue catalogue;
+    catalogue.AddStop({"A"sv, {55.60, 37.60}});
+    catalogue.AddStop({"B"sv, {55.61, 37.61}});
+    catalogue.AddStop({"C"sv, {55.62, 37.60}});
+    const Stop* a = catalogue.FindStop("A"sv);
+    const Stop* b = catalogue.FindStop("B"sv);
+    const Stop* c = catalogue.FindStop("C"sv);
+    catalogue.SetDistanceBetweenStops(a, b, 1000);
+    catalogue.SetDistanceBetweenStops(b, c, 2000);
+    catalogue.SetDistanceBetweenStops(a, c, 6000);
+    catalogue.AddBus({"1"sv, {a, b, c}, false});
+    catalogue.Freeze();
+
+    TransportRouteSettings settings;
+    settings.bus_wait_time = 6;
+    settings.bus_velocity = 60;
+    settings.bus_graph_model = bus_graph_model;
+    settings.router_mode = router_mode;
+    const TransportRouter router(settings, catalogue);
+
+    TransportCatalogue catalogue_copy(catalogue);
+    TransportRouter router_copy(router, catalogue_copy);
+    const Stop* a_copy = catalogue_copy.FindStop("A"sv);
+    const Stop* c_copy = catalogue_copy.FindStop("C"sv);
+    Check(a_copy != a && a_copy->stop_name == "A"sv, context + ": copied stop is shared"s);
+    catalogue_copy.UpdateBus({"1"sv, {a_copy, c_copy}, false});
+    router_copy.Update(catalogue_copy, catalogue_copy.TakeChangedBuses());
+
+    CheckRoute(router, a, c, 9.0, {{true, 0, 6.0}, {false, 2, 3.0}}, context + " original A -> C"s);
+    Check(catalogue.GetBusInfo(catalogue.FindBus("1"sv)).route_length == 6000, context + ": original bus changed"s);
+    CheckRoute(router_copy, a_copy, c_copy, 12.0, {{true, 0, 6.0}, {false, 1, 6.0}}, context + " copy A -> C"s);
+    const auto route = router_copy.FindOptimalRoute(a_copy, c_copy);
+    route->ForEachItem([&](const TransportRouter::EdgeInfo& edge_info) {
+        if (const auto* wait_info = std::get_if<TransportRouter::WaitEdgeInfo>(&edge_info)) {
+            Check(wait_info->stop == a_copy, context + ": copy refers to the original stop"s);
+        } else {
+            Check(std::get<TransportRouter::BusEdgeInfo>(edge_info).bus == catalogue_copy.FindBus("1"sv),
+                  context + ": copy refers to the original bus"s);
+        }
+    });
+}
+
+}  // namespace
+
+int main() {
+    const std::vector<std::pair<BusGraphModel, std::string>> bus_graph_models = {
+        {BusGraphModel::STOP_PAIRS, "stop_pairs"s},
+        {BusGraphModel::RIDE_VERTICES, "ride_vertices"s},
+    };
+    const std::vector<std::pair<graph::RouterMode, std::string>> router_modes = {
+        {graph::RouterMode::ALL_PAIRS, "all_pairs"s},
+        {graph::RouterMode::ALL_PAIRS_BLOCKED, "all_pairs_blocked"s},
+        {graph::RouterMode::DIJKSTRA, "dijkstra"s},
+        {graph::RouterMode::CONTRACTION_HIERARCHIES, "contraction_hierarchies"s},
+    };
+    try {
+        for (const auto& [bus_graph_model, model_name] : bus_graph_models) {
+            for (const auto& [router_mode, mode_name] : router_modes) {
+                TestAsymmetricRoadDistances(bus_graph_model, router_mode, model_name + "/"s + mode_name);
+                TestUpdateMatchesRebuild(bus_graph_model, router_mode, model_name + "/"s + mode_name);
+                TestCopyIsIndependent(bus_graph_model, router_mode, model_name + "/"s + mode_name);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: "sv << e.what() << std::endl;
+        return 1;
+    }
+    std::cerr << "transport_router_test OK"sv << std::endl;
+    return 0;
+}
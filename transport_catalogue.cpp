@@ -1,32 +1,303 @@
 #include "transport_catalogue.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <stdexcept>
-#include <unordered_set>
+#include <thread>
 
 namespace transport{
 
+    namespace {
+        std::vector<RoadDistance>::iterator FindRoadDistance(std::vector<RoadDistance>& road_distances, StopId to) {
+            return std::lower_bound(
+                road_distances.begin(),
+                road_distances.end(),
+                to,
+                [](const RoadDistance& road_distance, StopId stop_id) {
+                    return road_distance.to < stop_id;
+                }
+            );
+        }
+
+        // Записывает расстояние. Заданное явно расстояние не заменяется расстоянием в обратную сторону
+        void SetRoadDistance(std::vector<RoadDistance>& road_distances, const RoadDistance& road_distance) {
+            const auto it = FindRoadDistance(road_distances, road_distance.to);
+            if (it == road_distances.end() || it->to != road_distance.to) {
+                road_distances.insert(it, road_distance);
+            } else if (road_distance.is_explicit || !it->is_explicit) {
+                *it = road_distance;
+            }
+        }
+    } // namespace
+
+    TransportCatalogue::TransportCatalogue(const TransportCatalogue& other)
+    : stops_(other.stops_)
+    , stop_coordinates_(other.stop_coordinates_)
+    , stop_prepared_coordinates_(other.stop_prepared_coordinates_)
+    , stop_names_(other.stop_names_)
+    , names_(other.names_)
+    , name_to_stop_(other.name_to_stop_)
+    , name_to_bus_(other.name_to_bus_)
+    , sorted_stops_(other.sorted_stops_)
+    , buses_(other.buses_)
+    , sorted_buses_(other.sorted_buses_)
+    , bus_ride_lengths_(other.bus_ride_lengths_)
+    , bus_infos_(other.bus_infos_)
+    , road_distances_(other.road_distances_)
+    , stop_to_buses_(other.stop_to_buses_)
+    , is_stop_removed_(other.is_stop_removed_)
+    , is_bus_removed_(other.is_bus_removed_)
+    , is_frozen_(other.is_frozen_)
+    , changed_buses_(other.changed_buses_)
+    {
+        // Названия общие, а указатели на остановки и автобусы other заменяются указателями
+        // на объекты копии с теми же номерами
+        auto to_own_stop = [this](const Stop*& stop) {
+            if (stop) {
+                stop = &stops_[stop->id];
+            }
+        };
+        auto to_own_bus = [this](const Bus*& bus) {
+            if (bus) {
+                bus = &buses_[bus->id];
+            }
+        };
+        std::for_each(name_to_stop_.begin(), name_to_stop_.end(), to_own_stop);
+        std::for_each(sorted_stops_.begin(), sorted_stops_.end(), to_own_stop);
+        for (Bus& bus : buses_) {
+            std::for_each(bus.stops.begin(), bus.stops.end(), to_own_stop);
+        }
+        std::for_each(name_to_bus_.begin(), name_to_bus_.end(), to_own_bus);
+        std::for_each(sorted_buses_.begin(), sorted_buses_.end(), to_own_bus);
+        for (std::vector<const Bus*>& stop_buses : stop_to_buses_) {
+            std::for_each(stop_buses.begin(), stop_buses.end(), to_own_bus);
+        }
+    }
+
     void TransportCatalogue::AddStop(const Stop& stop) {
-        stops_.push_front(stop);
-        stopname_to_stop_[stops_.front().stop_name] = &stops_.front();
+        Stop& added_stop = stops_.emplace_back(stop);
+        added_stop.id = static_cast<StopId>(stops_.size() - 1);
+        const NameId name_id = names_.Intern(stop.stop_name);
+        added_stop.stop_name = names_.GetName(name_id);
+        stop_coordinates_.push_back(added_stop.coordinates);
+        stop_prepared_coordinates_.push_back(geo::PrepareCoordinates(added_stop.coordinates));
+        stop_names_.push_back(added_stop.stop_name);
+        road_distances_.emplace_back();
+        stop_to_buses_.emplace_back();
+        is_stop_removed_.push_back(false);
+        name_to_stop_.resize(names_.GetNameCount(), nullptr);
+        name_to_stop_[name_id] = &added_stop;
+        sorted_stops_.insert(
+            std::upper_bound(sorted_stops_.begin(), sorted_stops_.end(), &added_stop, StopComparator{}),
+            &added_stop
+        );
     }
 
     const Stop* TransportCatalogue::FindStop(std::string_view stop_name) const {
-        auto it = stopname_to_stop_.find(stop_name);
-        return it != stopname_to_stop_.end() ? it->second : nullptr;
+        const std::optional<NameId> name_id = names_.Find(stop_name);
+        return name_id && *name_id < name_to_stop_.size() ? name_to_stop_[*name_id] : nullptr;
     }
 
     void TransportCatalogue::AddBus(const Bus& bus) {
-        buses_.push_front(bus);
-        busname_to_bus_[buses_.front().bus_name] = &buses_.front();
-        for (const Stop* stop : buses_.front().stops) {
-            stop_to_buses_[stop].insert(&buses_.front());
+        Bus& added_bus = buses_.emplace_back(bus);
+        added_bus.id = static_cast<BusId>(buses_.size() - 1);
+        const NameId name_id = names_.Intern(bus.bus_name);
+        added_bus.bus_name = names_.GetName(name_id);
+        name_to_bus_.resize(names_.GetNameCount(), nullptr);
+        name_to_bus_[name_id] = &added_bus;
+        if (!added_bus.stops.empty()) {
+            sorted_buses_.insert(
+                std::upper_bound(sorted_buses_.begin(), sorted_buses_.end(), &added_bus, BusComparator{}),
+                &added_bus
+            );
+        }
+        AddBusToStops(&added_bus);
+        bus_ride_lengths_.emplace_back();
+        bus_infos_.emplace_back();
+        is_bus_removed_.push_back(false);
+        ComputeBusRideLengths(added_bus);
+    }
+
+    void TransportCatalogue::AddBusToStops(const Bus* bus) {
+        for (const Stop* stop : bus->stops) {
+            std::vector<const Bus*>& stop_buses = stop_to_buses_.at(stop->id);
+            const auto it = std::lower_bound(stop_buses.begin(), stop_buses.end(), bus, BusComparator{});
+            if (it == stop_buses.end() || *it != bus) {
+                stop_buses.insert(it, bus);
+            }
+        }
+    }
+
+    void TransportCatalogue::RemoveBusFromStops(const Bus* bus) {
+        for (const Stop* stop : bus->stops) {
+            std::vector<const Bus*>& stop_buses = stop_to_buses_.at(stop->id);
+            const auto it = std::lower_bound(stop_buses.begin(), stop_buses.end(), bus, BusComparator{});
+            if (it != stop_buses.end() && *it == bus) {
+                stop_buses.erase(it);
+            }
+        }
+    }
+
+    void TransportCatalogue::UpdateStop(const Stop& stop) {
+        const Stop* found_stop = FindStop(stop.stop_name);
+        if (!found_stop) {
+            AddStop(stop);
+            return;
+        }
+        Stop& cur_stop = stops_[found_stop->id];
+        if (cur_stop.coordinates == stop.coordinates) {
+            return;
+        }
+        cur_stop.coordinates = stop.coordinates;
+        stop_coordinates_[cur_stop.id] = stop.coordinates;
+        stop_prepared_coordinates_[cur_stop.id] = geo::PrepareCoordinates(stop.coordinates);
+        // Координаты влияют только на длины маршрутов по прямой
+        for (const Bus* bus : stop_to_buses_[cur_stop.id]) {
+            ComputeBusRideLengths(*bus);
+        }
+    }
+
+    void TransportCatalogue::UpdateBus(const Bus& bus) {
+        const Bus* found_bus = FindBus(bus.bus_name);
+        if (!found_bus) {
+            AddBus(bus);
+            return;
+        }
+        ReplaceBusStops(buses_[found_bus->id], bus.stops, bus.is_roundtrip);
+    }
+
+    void TransportCatalogue::ReplaceBusStops(Bus& bus, std::vector<const Stop*> stops, bool is_roundtrip) {
+        const auto [sorted_begin, sorted_end] = std::equal_range(sorted_buses_.begin(), sorted_buses_.end(), &bus, BusComparator{});
+        if (const auto sorted_it = std::find(sorted_begin, sorted_end, &bus); sorted_it != sorted_end) {
+            sorted_buses_.erase(sorted_it);
+        }
+        RemoveBusFromStops(&bus);
+
+        bus.stops = std::move(stops);
+        bus.is_roundtrip = is_roundtrip;
+        if (!bus.stops.empty()) {
+            sorted_buses_.insert(
+                std::upper_bound(sorted_buses_.begin(), sorted_buses_.end(), &bus, BusComparator{}),
+                &bus
+            );
+        }
+        AddBusToStops(&bus);
+        ComputeBusRideLengths(bus);
+    }
+
+    void TransportCatalogue::RemoveBus(const Bus* bus) {
+        using namespace std::literals;
+        if (!bus || IsBusRemoved(bus->id)) {
+            throw std::invalid_argument("Bus not found"s);
+        }
+        // Пустой маршрут убирает автобус из упорядоченного списка и со всех остановок
+        ReplaceBusStops(buses_[bus->id], {}, bus->is_roundtrip);
+        // Под тем же названием может быть зарегистрирован уже другой автобус
+        if (const std::optional<NameId> name_id = names_.Find(bus->bus_name); name_to_bus_[*name_id] == bus) {
+            name_to_bus_[*name_id] = nullptr;
+        }
+        is_bus_removed_[bus->id] = true;
+    }
+
+    void TransportCatalogue::RemoveStop(const Stop* stop) {
+        using namespace std::literals;
+        if (!stop || IsStopRemoved(stop->id)) {
+            throw std::invalid_argument("Stop not found"s);
+        }
+        if (!stop_to_buses_[stop->id].empty()) {
+            throw std::invalid_argument("Stop "s + std::string(stop->stop_name) + " is used by buses"s);
+        }
+        // Через остановку не ходят автобусы, поэтому её расстояния не входят ни в одну длину маршрута
+        for (const RoadDistance& road_distance : road_distances_[stop->id]) {
+            std::vector<RoadDistance>& neighbour_distances = road_distances_[road_distance.to];
+            const auto it = FindRoadDistance(neighbour_distances, stop->id);
+            if (it != neighbour_distances.end() && it->to == stop->id) {
+                neighbour_distances.erase(it);
+            }
+        }
+        road_distances_[stop->id].clear();
+
+        const auto [sorted_begin, sorted_end] = std::equal_range(sorted_stops_.begin(), sorted_stops_.end(), stop, StopComparator{});
+        if (const auto sorted_it = std::find(sorted_begin, sorted_end, stop); sorted_it != sorted_end) {
+            sorted_stops_.erase(sorted_it);
+        }
+        if (const std::optional<NameId> name_id = names_.Find(stop->stop_name); name_to_stop_[*name_id] == stop) {
+            name_to_stop_[*name_id] = nullptr;
+        }
+        is_stop_removed_[stop->id] = true;
+    }
+
+    bool TransportCatalogue::IsStopRemoved(StopId stop_id) const {
+        return is_stop_removed_.at(stop_id);
+    }
+
+    bool TransportCatalogue::IsBusRemoved(BusId bus_id) const {
+        return is_bus_removed_.at(bus_id);
+    }
+
+    std::vector<BusId> TransportCatalogue::TakeChangedBuses() {
+        std::vector<BusId> changed_buses = std::move(changed_buses_);
+        changed_buses_.clear();
+        std::sort(changed_buses.begin(), changed_buses.end());
+        changed_buses.erase(std::unique(changed_buses.begin(), changed_buses.end()), changed_buses.end());
+        return changed_buses;
+    }
+
+    void TransportCatalogue::ComputeBusRideLengths(const Bus& bus) {
+        bus_infos_[bus.id].reset();
+        if (is_frozen_) {
+            changed_buses_.push_back(bus.id);
+        }
+        // Новые длины, а не изменение прежних: прежние могут принадлежать и копии справочника
+        auto ride_lengths_ptr = std::make_shared<BusRideLengths>();
+        BusRideLengths& ride_lengths = *ride_lengths_ptr;
+        const size_t stops_amount = bus.stops.size();
+        ride_lengths.forward_road_lengths.assign(stops_amount, 0);
+        ride_lengths.backward_road_lengths.assign(stops_amount, 0);
+        ride_lengths.geo_lengths.assign(stops_amount, 0.0);
+        bus_ride_lengths_[bus.id] = ride_lengths_ptr;
+        if (stops_amount == 0) {
+            return;
         }
+
+        // Длины всех перегонов по прямой считаются одним пакетом: элемент i — перегон от i-й остановки к (i+1)-й
+        std::vector<geo::PreparedCoordinates> ride_coordinates;
+        ride_coordinates.reserve(stops_amount);
+        for (const Stop* stop : bus.stops) {
+            ride_coordinates.push_back(stop_prepared_coordinates_[stop->id]);
+        }
+        std::vector<double> geo_spans(stops_amount - 1);
+        const std::span<const geo::PreparedCoordinates> ride_span = ride_coordinates;
+        geo::ComputeDistances(ride_span.first(stops_amount - 1), ride_span.subspan(1), geo_spans);
+
+        for (size_t i = 1; i < stops_amount; ++i) {
+            const Stop* prev_stop = bus.stops[i - 1];
+            const Stop* stop = bus.stops[i];
+            ride_lengths.forward_road_lengths[i] = ride_lengths.forward_road_lengths[i - 1]
+                + GetDistanceBetweenStops(prev_stop, stop);
+            ride_lengths.backward_road_lengths[i] = ride_lengths.backward_road_lengths[i - 1]
+                + GetDistanceBetweenStops(stop, prev_stop);
+            ride_lengths.geo_lengths[i] = ride_lengths.geo_lengths[i - 1]
+                + geo_spans[i - 1];
+        }
+    }
+
+    int TransportCatalogue::GetRideDistance(const Bus* bus, size_t from, size_t to) const {
+        const BusRideLengths& ride_lengths = *bus_ride_lengths_.at(bus->id);
+        return from <= to
+            ? ride_lengths.forward_road_lengths.at(to) - ride_lengths.forward_road_lengths.at(from)
+            : ride_lengths.backward_road_lengths.at(from) - ride_lengths.backward_road_lengths.at(to);
+    }
+
+    double TransportCatalogue::GetRideGeoDistance(const Bus* bus, size_t from, size_t to) const {
+        const BusRideLengths& ride_lengths = *bus_ride_lengths_.at(bus->id);
+        return std::abs(ride_lengths.geo_lengths.at(to) - ride_lengths.geo_lengths.at(from));
     }
 
     const Bus* TransportCatalogue::FindBus(std::string_view bus_name) const {
-        auto it = busname_to_bus_.find(bus_name);
-        return it != busname_to_bus_.end() ? it->second : nullptr;
+        const std::optional<NameId> name_id = names_.Find(bus_name);
+        return name_id && *name_id < name_to_bus_.size() ? name_to_bus_[*name_id] : nullptr;
     }
 
     BusInfo TransportCatalogue::GetBusInfo(const Bus* bus) const {
@@ -34,63 +305,173 @@ namespace transport{
         if (!bus) {
             throw std::invalid_argument("Bus not found"s);
         }
-        std::unordered_set<const Stop*> unique_stops;
-        int route_length = 0;
-        double geo_length = 0.0;
-        for (size_t i = 0; i < bus->stops.size() - 1; ++i) {
-            unique_stops.insert(bus->stops[i]);
-            route_length += GetDistanceBetweenStops(bus->stops[i], bus->stops[i+1]);
-            geo_length += geo::ComputeDistance(bus->stops[i]->coordinates, bus->stops[i+1]->coordinates);
-        }
-        unique_stops.insert(bus->stops.back());
-        if (!bus->is_roundtrip) {
-            for (size_t i = bus->stops.size() - 1; i > 0; --i) {
-                route_length += GetDistanceBetweenStops(bus->stops[i], bus->stops[i - 1]);
-                geo_length += geo::ComputeDistance(bus->stops[i]->coordinates, bus->stops[i - 1]->coordinates);
+        if (const std::optional<BusInfo>& bus_info = bus_infos_.at(bus->id)) {
+            return *bus_info;
+        }
+        return ComputeBusInfo(*bus);
+    }
+
+    BusInfo TransportCatalogue::ComputeBusInfo(const Bus& bus) const {
+        // Автобус без остановок, например после UpdateBus с пустым списком, маршрута не имеет
+        if (bus.stops.empty()) {
+            return {0, 0, 0, 0.0};
+        }
+        std::vector<StopId> unique_stops;
+        unique_stops.reserve(bus.stops.size());
+        for (const Stop* stop : bus.stops) {
+            unique_stops.push_back(stop->id);
+        }
+        std::sort(unique_stops.begin(), unique_stops.end());
+        const size_t unique_stop_count = std::unique(unique_stops.begin(), unique_stops.end()) - unique_stops.begin();
+
+        const size_t last_stop = bus.stops.size() - 1;
+        int route_length = GetRideDistance(&bus, 0, last_stop);
+        double geo_length = GetRideGeoDistance(&bus, 0, last_stop);
+        if (!bus.is_roundtrip) {
+            route_length += GetRideDistance(&bus, last_stop, 0);
+            geo_length *= 2;
+        }
+        return {(bus.is_roundtrip ? bus.stops.size() : bus.stops.size() * 2 - 1), unique_stop_count, route_length, route_length/geo_length};
+    }
+
+    void TransportCatalogue::Freeze(size_t thread_count) {
+        // Каждый поток заполняет свой непрерывный диапазон номеров автобусов
+        is_frozen_ = true;
+        names_.Freeze();
+        thread_count = std::clamp<size_t>(thread_count, 1, std::max<size_t>(buses_.size(), 1));
+        auto compute_bus_infos = [this](size_t begin, size_t end) {
+            for (BusId bus_id = static_cast<BusId>(begin); bus_id < end; ++bus_id) {
+                const Bus& bus = buses_[bus_id];
+                if (!bus_infos_[bus_id]) {
+                    bus_infos_[bus_id] = ComputeBusInfo(bus);
+                }
             }
+        };
+
+        std::vector<std::thread> workers;
+        workers.reserve(thread_count - 1);
+        const size_t chunk_size = (buses_.size() + thread_count - 1) / thread_count;
+        for (size_t i = 1; i < thread_count; ++i) {
+            workers.emplace_back(compute_bus_infos, i * chunk_size, std::min((i + 1) * chunk_size, buses_.size()));
+        }
+        compute_bus_infos(0, std::min(chunk_size, buses_.size()));
+        for (std::thread& worker : workers) {
+            worker.join();
         }
-        return {(bus->is_roundtrip ? bus->stops.size() : bus->stops.size() * 2 - 1), unique_stops.size(), route_length, route_length/geo_length};
     }
 
     void TransportCatalogue::SetDistanceBetweenStops(const Stop* from, const Stop* to, int distance) {
-        stop_to_stop_distances_[{from, to}] = distance;
+        SetRoadDistance(road_distances_.at(from->id), {to->id, distance, true});
+        SetRoadDistance(road_distances_.at(to->id), {from->id, distance, false});
+        // Обычно расстояния задаются до добавления автобусов, иначе пересчитываются длины их маршрутов
+        for (const Bus* bus : stop_to_buses_[from->id]) {
+            ComputeBusRideLengths(*bus);
+        }
+    }
+
+    void TransportCatalogue::RemoveDistanceBetweenStops(const Stop* from, const Stop* to) {
+        std::vector<RoadDistance>& from_distances = road_distances_.at(from->id);
+        std::vector<RoadDistance>& to_distances = road_distances_.at(to->id);
+        const auto from_it = FindRoadDistance(from_distances, to->id);
+        if (from_it == from_distances.end() || from_it->to != to->id || !from_it->is_explicit) {
+            return;
+        }
+        const auto to_it = FindRoadDistance(to_distances, from->id);
+        if (to_it != to_distances.end() && to_it->to == from->id && to_it->is_explicit) {
+            // Осталось расстояние в обратную сторону — теперь оно действует в обе стороны
+            *from_it = {to->id, to_it->distance, false};
+        } else {
+            from_distances.erase(from_it);
+            if (to_it != to_distances.end() && to_it->to == from->id) {
+                to_distances.erase(to_it);
+            }
+        }
+        for (const Bus* bus : stop_to_buses_[from->id]) {
+            ComputeBusRideLengths(*bus);
+        }
     }
 
     int TransportCatalogue::GetDistanceBetweenStops(const Stop* stop_1, const Stop* stop_2) const {
-        auto it = stop_to_stop_distances_.find({stop_1, stop_2});
-        if (it == stop_to_stop_distances_.end()) {
-            it = stop_to_stop_distances_.find({stop_2, stop_1});
+        for (const RoadDistance& road_distance : road_distances_[stop_1->id]) {
+            if (road_distance.to >= stop_2->id) {
+                return road_distance.to == stop_2->id ? road_distance.distance : 0;
+            }
         }
-        return it != stop_to_stop_distances_.end() ? it->second : 0;
+        return 0;
     }
 
-    std::set<const Bus*, BusComparator> TransportCatalogue::GetStopToBuses(const Stop* stop) const {
+    std::span<const Bus* const> TransportCatalogue::GetStopToBuses(const Stop* stop) const {
         using namespace std::literals;
         if (!stop) {
             throw std::invalid_argument("Stop not found"s);
         }
-        if (stop_to_buses_.count(stop)) {
-            return stop_to_buses_.at(stop);
-        }
-        return {};
+        return stop_to_buses_.at(stop->id);
     }
 
-    const std::set<const Bus*, BusComparator> TransportCatalogue::GetBusesSortedByName() const {
-        std::set<const Bus*, BusComparator> sorted_buses;
-        for (const Bus& bus : buses_) {
-            if (bus.stops.size() > 0) {
-                sorted_buses.insert(&bus);
-            }
-        }
-        return sorted_buses;
+    std::span<const Bus* const> TransportCatalogue::GetBusesSortedByName() const {
+        return sorted_buses_;
     }
 
-    const std::set<const Stop*, StopComparator> TransportCatalogue::GetStopsSortedByName() const {
-        std::set<const Stop*, StopComparator> sorted_stops;
-        for (const Stop& stop : stops_) {
-            sorted_stops.insert(&stop);
-        }
-        return sorted_stops;
+    std::span<const Stop* const> TransportCatalogue::GetStopsSortedByName() const {
+        return sorted_stops_;
+    }
+
+    size_t TransportCatalogue::GetStopCount() const {
+        return stops_.size();
+    }
+
+    size_t TransportCatalogue::GetBusCount() const {
+        return buses_.size();
+    }
+
+    const Stop* TransportCatalogue::GetStop(StopId stop_id) const {
+        return &stops_.at(stop_id);
+    }
+
+    const Bus* TransportCatalogue::GetBus(BusId bus_id) const {
+        return &buses_.at(bus_id);
+    }
+
+    std::optional<StopId> TransportCatalogue::FindStopId(std::string_view stop_name) const {
+        const Stop* stop = FindStop(stop_name);
+        return stop ? std::optional<StopId>(stop->id) : std::nullopt;
+    }
+
+    std::optional<BusId> TransportCatalogue::FindBusId(std::string_view bus_name) const {
+        const Bus* bus = FindBus(bus_name);
+        return bus ? std::optional<BusId>(bus->id) : std::nullopt;
+    }
+
+    std::string_view TransportCatalogue::GetStopName(StopId stop_id) const {
+        return stop_names_.at(stop_id);
+    }
+
+    const geo::Coordinates& TransportCatalogue::GetStopCoordinates(StopId stop_id) const {
+        return stop_coordinates_.at(stop_id);
+    }
+
+    std::span<const geo::Coordinates> TransportCatalogue::GetStopsCoordinates() const {
+        return stop_coordinates_;
+    }
+
+    std::span<const geo::PreparedCoordinates> TransportCatalogue::GetStopsPreparedCoordinates() const {
+        return stop_prepared_coordinates_;
+    }
+
+    std::span<const std::string_view> TransportCatalogue::GetStopsNames() const {
+        return stop_names_;
+    }
+
+    const std::deque<Stop>& TransportCatalogue::GetStops() const {
+        return stops_;
+    }
+
+    const std::deque<Bus>& TransportCatalogue::GetBuses() const {
+        return buses_;
+    }
+
+    std::span<const RoadDistance> TransportCatalogue::GetRoadDistances(StopId stop_id) const {
+        return road_distances_.at(stop_id);
     }
 
 } // namespace transport
\ No newline at end of file
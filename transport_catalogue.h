@@ -1,60 +1,141 @@
 #pragma once
 
 #include "domain.h"
+#include "name_arena.h"
 
-#include <forward_list>
+#include <deque>
 #include <map>
-#include <set>
+#include <memory>
+#include <optional>
+#include <span>
 #include <string_view>
-#include <unordered_map>
+#include <vector>
 
 namespace transport {
 
-struct StopToStopHasher {
-    size_t operator() (const std::pair<const Stop*, const Stop*>& stop_to_stop) const {
-		size_t hash_1 = (
-			static_cast<size_t>(stop_to_stop.first->coordinates.lat) *
-			static_cast<size_t>(stop_to_stop.first->coordinates.lng) +
-			str_hasher_(stop_to_stop.first->stop_name)
-		);
-		size_t hash_2 = (
-			static_cast<size_t>(stop_to_stop.second->coordinates.lat) *
-			static_cast<size_t>(stop_to_stop.second->coordinates.lng) +
-			str_hasher_(stop_to_stop.second->stop_name)
-		);
-
-		return hash_1 + hash_2 * 109;
-    }
-private:
-	std::hash<std::string> str_hasher_;
+// Расстояние по дорогам от остановки до соседней. Если расстояние в эту сторону не задано,
+// хранится заданное в обратную сторону с is_explicit == false
+struct RoadDistance {
+	StopId to;
+	int distance;
+	bool is_explicit;
 };
 
 class TransportCatalogue {
 public:
+	TransportCatalogue() = default;
+	// Независимая копия: её остановки и автобусы — свои объекты, и указатели в ней ведут на них.
+	// Неизменяемые части — блоки названий и длины перегонов автобусов — копия делит с other
+	TransportCatalogue(const TransportCatalogue& other);
+	TransportCatalogue& operator=(const TransportCatalogue&) = delete;
+
 	void AddStop(const Stop& stop);
 	const Stop* FindStop(std::string_view stop_name) const;
 	void AddBus(const Bus& bus);
 	const Bus* FindBus(std::string_view bus_name) const;
+	// Берёт сведения, посчитанные в Freeze, а для автобусов, добавленных или изменённых позже, считает их заново
 	BusInfo GetBusInfo(const Bus* bus) const;
+	// Вызывается после загрузки базы: заранее считает сведения обо всех автобусах в thread_count потоков
+	void Freeze(size_t thread_count = 1);
 	void SetDistanceBetweenStops(const Stop* from, const Stop* to, int distance);
     int GetDistanceBetweenStops(const Stop* stop_1, const Stop* stop_2) const;
-	std::set<const Bus*, BusComparator> GetStopToBuses(const Stop* stop) const;
-	const std::set<const Bus*, BusComparator> GetBusesSortedByName() const;
-	const std::set<const Stop*, StopComparator> GetStopsSortedByName() const;
+
+	// Изменения работающего справочника. UpdateStop и UpdateBus добавляют новую остановку или автобус
+	// либо меняют координаты или маршрут существующего; пересчитываются только затронутые автобусы.
+	// Номера удалённых остановок и автобусов не переиспользуются, указатели на них остаются действительными
+	void UpdateStop(const Stop& stop);
+	void UpdateBus(const Bus& bus);
+	// Удалить можно только остановку, через которую не проходит ни один автобус
+	void RemoveStop(const Stop* stop);
+	void RemoveBus(const Bus* bus);
+	// Удаляет заданное расстояние from -> to. Если задано расстояние в обратную сторону, оно снова используется вместо удалённого
+	void RemoveDistanceBetweenStops(const Stop* from, const Stop* to);
+	bool IsStopRemoved(StopId stop_id) const;
+	bool IsBusRemoved(BusId bus_id) const;
+	// Номера автобусов, чьи маршруты или длины перегонов изменились после Freeze, без повторов.
+	// Журнал очищается, по нему маршрутизатор обновляет рёбра только этих автобусов
+	std::vector<BusId> TakeChangedBuses();
+	// Длина поездки на автобусе от остановки маршрута с индексом from до индекса to (индексы в bus->stops)
+	// по дорогам и по прямой. При from > to автобус едет в обратную сторону. Время работы O(1)
+	int GetRideDistance(const Bus* bus, size_t from, size_t to) const;
+	double GetRideGeoDistance(const Bus* bus, size_t from, size_t to) const;
+	// Автобусы, проходящие через остановку, упорядоченные по названию
+	std::span<const Bus* const> GetStopToBuses(const Stop* stop) const;
+	// Упорядоченные по названию автобусы с непустым маршрутом и все остановки.
+	// Порядок поддерживается при добавлении, поэтому вызов ничего не строит и не копирует
+	std::span<const Bus* const> GetBusesSortedByName() const;
+	std::span<const Stop* const> GetStopsSortedByName() const;
+
+	// Доступ по плотным номерам. Номера идут подряд с нуля в порядке добавления,
+	// поэтому данные, привязанные к остановкам и автобусам, можно хранить в обычных векторах
+	size_t GetStopCount() const;
+	size_t GetBusCount() const;
+	const Stop* GetStop(StopId stop_id) const;
+	const Bus* GetBus(BusId bus_id) const;
+	std::optional<StopId> FindStopId(std::string_view stop_name) const;
+	std::optional<BusId> FindBusId(std::string_view bus_name) const;
+	std::string_view GetStopName(StopId stop_id) const;
+	const geo::Coordinates& GetStopCoordinates(StopId stop_id) const;
+	std::span<const geo::Coordinates> GetStopsCoordinates() const;
+	// Координаты остановок с вычисленными при добавлении синусом и косинусом широты, индекс — StopId
+	std::span<const geo::PreparedCoordinates> GetStopsPreparedCoordinates() const;
+	std::span<const std::string_view> GetStopsNames() const;
+
+	// Полное содержимое справочника в порядке номеров, например для сериализации
+	const std::deque<Stop>& GetStops() const;
+	const std::deque<Bus>& GetBuses() const;
+	// Расстояния от остановки до соседних, упорядоченные по номеру соседней остановки
+	std::span<const RoadDistance> GetRoadDistances(StopId stop_id) const;
+	// Названия вместе с построенной в Freeze совершенной хэш-функцией, чтобы не строить её при загрузке.
+	// LoadNames вызывается до добавления остановок и автобусов, они получат те же номера названий
+	template <typename Archive>
+	void SaveNames(Archive& archive) const {
+		names_.Save(archive);
+	}
+	template <typename Archive>
+	void LoadNames(Archive& archive) {
+		names_.Load(archive);
+	}
 private:
-	std::forward_list<Stop> stops_;
-	std::unordered_map<std::string_view, const Stop*> stopname_to_stop_;
-	std::forward_list<Bus> buses_;
-	std::unordered_map<std::string_view, const Bus*> busname_to_bus_;
-	std::unordered_map<
-		std::pair<const Stop*, const Stop*>,
-		int,
-		StopToStopHasher
-	> stop_to_stop_distances_;
-	std::unordered_map<
-		const Stop*,
-		std::set<const Bus*, BusComparator>
-	> stop_to_buses_;
+	// Префиксные суммы длин перегонов маршрута: элемент i — расстояние от первой остановки до i-й.
+	// backward_road_lengths складывает длины тех же перегонов при движении в обратную сторону
+	struct BusRideLengths {
+		std::vector<int> forward_road_lengths;
+		std::vector<int> backward_road_lengths;
+		std::vector<double> geo_lengths;
+	};
+
+	// deque не перемещает элементы при добавлении, поэтому указатели на остановки и автобусы остаются действительными
+	std::deque<Stop> stops_;
+	// Часто читаемые поля остановок лежат ещё и в отдельных непрерывных массивах, индекс — StopId
+	std::vector<geo::Coordinates> stop_coordinates_;
+	std::vector<geo::PreparedCoordinates> stop_prepared_coordinates_;
+	std::vector<std::string_view> stop_names_;
+	// Названия остановок и автобусов хранятся один раз, в Stop::stop_name и Bus::bus_name — ссылки на них.
+	// Поиск по названию — один хэш в names_ и обращение к массиву по номеру названия.
+	// После Freeze names_ ищет совершенной хэш-функцией: одна ячейка на запрос
+	NameArena names_;
+	std::vector<const Stop*> name_to_stop_; // Индекс — NameId
+	std::vector<const Bus*> name_to_bus_;   // Индекс — NameId
+	std::vector<const Stop*> sorted_stops_;
+	std::deque<Bus> buses_;
+	std::vector<const Bus*> sorted_buses_;
+	// Индекс — BusId. Длины заменяются целиком при изменении автобуса, поэтому копии справочника их делят
+	std::vector<std::shared_ptr<const BusRideLengths>> bus_ride_lengths_;
+	std::vector<std::optional<BusInfo>> bus_infos_; // Индекс — BusId, пусто до Freeze
+	// Индекс — StopId. У остановки обычно единицы соседей, поэтому поиск — короткий проход по вектору
+	std::vector<std::vector<RoadDistance>> road_distances_;
+	std::vector<std::vector<const Bus*>> stop_to_buses_; // Индекс — StopId, автобусы упорядочены по названию
+	std::vector<bool> is_stop_removed_; // Индекс — StopId
+	std::vector<bool> is_bus_removed_; // Индекс — BusId
+	bool is_frozen_ = false; // После Freeze изменения автобусов записываются в changed_buses_
+	std::vector<BusId> changed_buses_;
+
+	void AddBusToStops(const Bus* bus);
+	void RemoveBusFromStops(const Bus* bus);
+	void ReplaceBusStops(Bus& bus, std::vector<const Stop*> stops, bool is_roundtrip);
+	void ComputeBusRideLengths(const Bus& bus);
+	BusInfo ComputeBusInfo(const Bus& bus) const;
 };
 
 } // namespace transport
\ No newline at end of file
@@ -4,94 +4,289 @@
 
 namespace transport {
 
-    void TransportRouter::AddStopsToGraph(
-        const std::set<const Stop*, StopComparator>& sorted_stops
+    size_t TransportRouter::CountVertexes(
+        size_t stops_amount,
+        const TransportCatalogue& catalogue
+    ) const {
+        size_t vertexes_amount = 2 * stops_amount;
+        for (const Bus* bus : catalogue.GetBusesSortedByName()) {
+            vertexes_amount += CountRideVertexes(bus);
+        }
+        return vertexes_amount;
+    }
+
+    size_t TransportRouter::CountRideVertexes(
+        const Bus* bus
+    ) const {
+        if (route_settings_.bus_graph_model != BusGraphModel::RIDE_VERTICES) {
+            return 0;
+        }
+        return bus->stops.size() * (bus->is_roundtrip ? 1 : 2);
+    }
+
+    void TransportRouter::AddStopToGraph(
+        const Stop* stop,
+        graph::VertexId& next_vertex_id
     ) {
-        graph::VertexId vertex_id = 0;
-        graph::EdgeId cur_edge_id = 0;
-
-        for (const Stop* stop : sorted_stops) {
-            stop_to_vertexes_ids_[stop] = StopVertexes{vertex_id++, vertex_id++};
-            cur_edge_id = graph_.AddEdge({
-                stop_to_vertexes_ids_.at(stop).in,
-                stop_to_vertexes_ids_.at(stop).out,
-                static_cast<double>(route_settings_.bus_wait_time)
-            });
-            edge_id_to_edge_info_[cur_edge_id] = WaitEdgeInfo {
-                stop,
-                static_cast<double>(route_settings_.bus_wait_time)
-            };
+        stop_to_vertexes_ids_[stop->id] = StopVertexes{next_vertex_id, next_vertex_id + 1};
+        next_vertex_id += 2;
+        AddEdge({
+            stop_to_vertexes_ids_[stop->id].in,
+            stop_to_vertexes_ids_[stop->id].out,
+            static_cast<double>(route_settings_.bus_wait_time)
+        }, WaitEdgeInfo {
+            stop,
+            static_cast<double>(route_settings_.bus_wait_time)
+        });
+    }
+
+    void TransportRouter::AddBusToGraph(
+        const TransportCatalogue& catalogue,
+        const Bus* bus,
+        graph::VertexId& next_vertex_id
+    ) {
+        if (route_settings_.bus_graph_model != BusGraphModel::RIDE_VERTICES) {
+            AddBusStopPairsToGraph(catalogue, bus);
+            return;
+        }
+        AddBusRideToGraph(catalogue, bus, bus->stops, next_vertex_id);
+        if (!bus->is_roundtrip) {
+            AddBusRideToGraph(
+                catalogue,
+                bus,
+                std::vector<const Stop*>{bus->stops.rbegin(), bus->stops.rend()},
+                next_vertex_id
+            );
         }
     }
 
-    void TransportRouter::AddBusesToGraph(
-        const TransportCatalogue& catalogue
+    void TransportRouter::AddBusStopPairsToGraph(
+        const TransportCatalogue& catalogue,
+        const Bus* bus
     ) {
-        std::set<const Bus*, BusComparator> sorted_buses = catalogue.GetBusesSortedByName();
-        graph::EdgeId cur_edge_id = 0;
-
-        for (const Bus* bus : sorted_buses) {
-            const std::vector<const Stop*>& cur_bus_stops = bus->stops;
-            size_t cur_bus_stops_amount = cur_bus_stops.size();
-            for (size_t from = 0; from < cur_bus_stops_amount; ++from) {
-                const Stop* stop_from = cur_bus_stops.at(from);
-                for (size_t to = from + 1; to < cur_bus_stops_amount; ++to) {
-                    const Stop* stop_to = cur_bus_stops.at(to);
-                    int cur_dist_between_stops = 0;
-                    int reverse_dist_between_stops = 0;
-                    for (size_t local = from + 1; local <= to; ++local) {
-                        cur_dist_between_stops += catalogue.GetDistanceBetweenStops(
-                            cur_bus_stops.at(local - 1),
-                            cur_bus_stops.at(local)
-                        );
-                        reverse_dist_between_stops += catalogue.GetDistanceBetweenStops(
-                            cur_bus_stops.at(local),
-                            cur_bus_stops.at(local - 1)
-                        );
-                    }
-                    cur_edge_id = graph_.AddEdge({
-                        stop_to_vertexes_ids_.at(stop_from).out,
-                        stop_to_vertexes_ids_.at(stop_to).in,
-                        static_cast<double>(cur_dist_between_stops) / (route_settings_.bus_velocity * FROM_KM_H_TO_M_MIN)
-                    });
-                    edge_id_to_edge_info_[cur_edge_id] = BusEdgeInfo{
+        const std::vector<const Stop*>& cur_bus_stops = bus->stops;
+        size_t cur_bus_stops_amount = cur_bus_stops.size();
+        for (size_t from = 0; from < cur_bus_stops_amount; ++from) {
+            const Stop* stop_from = cur_bus_stops.at(from);
+            for (size_t to = from + 1; to < cur_bus_stops_amount; ++to) {
+                const Stop* stop_to = cur_bus_stops.at(to);
+                const double cur_time = static_cast<double>(catalogue.GetRideDistance(bus, from, to)) / (route_settings_.bus_velocity * FROM_KM_H_TO_M_MIN);
+                AddEdge({
+                    stop_to_vertexes_ids_[stop_from->id].out,
+                    stop_to_vertexes_ids_[stop_to->id].in,
+                    cur_time
+                }, BusEdgeInfo{
+                    bus,
+                    to - from,
+                    cur_time
+                });
+                if (!bus->is_roundtrip) {
+                    const double reverse_time = static_cast<double>(catalogue.GetRideDistance(bus, to, from)) / (route_settings_.bus_velocity * FROM_KM_H_TO_M_MIN);
+                    AddEdge({
+                        stop_to_vertexes_ids_[stop_to->id].out,
+                        stop_to_vertexes_ids_[stop_from->id].in,
+                        reverse_time
+                    }, BusEdgeInfo{
                         bus,
                         to - from,
-                        static_cast<double>(cur_dist_between_stops) / (route_settings_.bus_velocity * FROM_KM_H_TO_M_MIN)
-                    };
-                    if (!bus->is_roundtrip) {
-                        cur_edge_id = graph_.AddEdge({
-                            stop_to_vertexes_ids_.at(stop_to).out,
-                            stop_to_vertexes_ids_.at(stop_from).in,
-                            static_cast<double>(reverse_dist_between_stops) / (route_settings_.bus_velocity * FROM_KM_H_TO_M_MIN)
-                        });
-                        edge_id_to_edge_info_[cur_edge_id] = BusEdgeInfo{
-                            bus,
-                            to - from,
-                            static_cast<double>(cur_dist_between_stops) / (route_settings_.bus_velocity * FROM_KM_H_TO_M_MIN)
-                        };
-                    }
+                        reverse_time
+                    });
                 }
             }
         }
     }
 
-    TransportRouter::CompleteRouteInfo TransportRouter::FindOptimalRoute(
+    // Каждой остановке поездки соответствует своя вершина. Посадка (out остановки -> поездка)
+    // и высадка (поездка -> in остановки) бесплатны, перегон между соседними вершинами поездки
+    // весит время в пути. В ответе подряд идущие рёбра поездки склеиваются в один элемент Bus
+    void TransportRouter::AddBusRideToGraph(
+        const TransportCatalogue& catalogue,
+        const Bus* bus,
+        const std::vector<const Stop*>& ride_stops,
+        graph::VertexId& next_vertex_id
+    ) {
+        for (size_t index = 0; index < ride_stops.size(); ++index) {
+            const graph::VertexId ride_vertex_id = next_vertex_id + index;
+            const StopVertexes& stop_vertexes = stop_to_vertexes_ids_[ride_stops[index]->id];
+            if (index + 1 < ride_stops.size()) {
+                AddEdge({stop_vertexes.out, ride_vertex_id, 0.0}, BusEdgeInfo{bus, 0, 0.0});
+            }
+            if (index > 0) {
+                const double time = static_cast<double>(catalogue.GetDistanceBetweenStops(
+                    ride_stops[index - 1],
+                    ride_stops[index]
+                )) / (route_settings_.bus_velocity * FROM_KM_H_TO_M_MIN);
+                AddEdge({ride_vertex_id - 1, ride_vertex_id, time}, BusEdgeInfo{bus, 1, time});
+
+                AddEdge({ride_vertex_id, stop_vertexes.in, 0.0}, BusEdgeInfo{bus, 0, 0.0});
+            }
+        }
+        next_vertex_id += ride_stops.size();
+    }
+
+    const TransportRouter::StopVertexes& TransportRouter::GetStopVertexes(const Stop* stop) const {
+        using namespace std::literals;
+        if (!stop || stop->id >= stop_to_vertexes_ids_.size()) {
+            throw std::out_of_range("Stop is not in the route graph"s);
+        }
+        return stop_to_vertexes_ids_[stop->id];
+    }
+
+    TransportRouter::TransportRouter(const TransportRouter& other, const TransportCatalogue& catalogue)
+    : route_settings_(other.route_settings_)
+    , graph_(other.graph_)
+    , router_(other.router_)
+    , stop_to_vertexes_ids_(other.stop_to_vertexes_ids_)
+    {
+        edges_info_.reserve(other.edges_info_.size());
+        for (const EdgeInfo& edge_info : other.edges_info_) {
+            if (const auto* wait_info = std::get_if<WaitEdgeInfo>(&edge_info)) {
+                edges_info_.push_back(WaitEdgeInfo{catalogue.GetStop(wait_info->stop->id), wait_info->bus_wait_time});
+            } else {
+                const BusEdgeInfo& bus_info = std::get<BusEdgeInfo>(edge_info);
+                edges_info_.push_back(BusEdgeInfo{catalogue.GetBus(bus_info.bus->id), bus_info.span_count, bus_info.time});
+            }
+        }
+    }
+
+    void TransportRouter::AddEdge(const graph::Edge<double>& edge, const EdgeInfo& edge_info) {
+        graph_->AddEdge(edge);
+        edges_info_.push_back(edge_info);
+    }
+
+    void TransportRouter::Update(const TransportCatalogue& catalogue, std::span<const BusId> changed_buses) {
+        const size_t old_stop_count = stop_to_vertexes_ids_.size();
+        if (changed_buses.empty() && catalogue.GetStopCount() == old_stop_count) {
+            return;
+        }
+        std::vector<bool> is_bus_changed(catalogue.GetBusCount(), false);
+        for (const BusId bus_id : changed_buses) {
+            is_bus_changed[bus_id] = true;
+        }
+
+        // Маршрутизатор ссылается на граф, поэтому удаляется до его замены. Прежние граф и маршрутизатор
+        // могут использоваться копиями, поэтому не меняются, а заменяются новыми
+        router_.reset();
+        const std::shared_ptr<const graph::DirectedWeightedGraph<double>> old_graph = std::move(graph_);
+        const std::vector<EdgeInfo> old_edges_info = std::move(edges_info_);
+
+        // Вершины поездок изменённых и удалённых автобусов остаются без рёбер. Чтобы граф и таблицы
+        // маршрутизатора не росли с каждым обновлением, остальные вершины — вершины остановок и концы
+        // перенесённых рёбер — получают новые номера подряд в прежнем порядке
+        std::vector<bool> is_edge_kept(old_graph->GetEdgeCount(), false);
+        std::vector<bool> is_vertex_kept(old_graph->GetVertexCount(), false);
+        for (const StopVertexes& stop_vertexes : stop_to_vertexes_ids_) {
+            is_vertex_kept[stop_vertexes.in] = true;
+            is_vertex_kept[stop_vertexes.out] = true;
+        }
+        for (graph::EdgeId edge_id = 0; edge_id < old_graph->GetEdgeCount(); ++edge_id) {
+            const auto* bus_info = std::get_if<BusEdgeInfo>(&old_edges_info[edge_id]);
+            if (!bus_info || !is_bus_changed[bus_info->bus->id]) {
+                const graph::Edge<double>& edge = old_graph->GetEdge(edge_id);
+                is_edge_kept[edge_id] = true;
+                is_vertex_kept[edge.from] = true;
+                is_vertex_kept[edge.to] = true;
+            }
+        }
+        std::vector<graph::VertexId> new_vertex_ids(old_graph->GetVertexCount());
+        graph::VertexId next_vertex_id = 0;
+        for (graph::VertexId vertex_id = 0; vertex_id < old_graph->GetVertexCount(); ++vertex_id) {
+            if (is_vertex_kept[vertex_id]) {
+                new_vertex_ids[vertex_id] = next_vertex_id++;
+            }
+        }
+
+        size_t vertexes_amount = next_vertex_id + 2 * (catalogue.GetStopCount() - old_stop_count);
+        for (const BusId bus_id : changed_buses) {
+            vertexes_amount += CountRideVertexes(catalogue.GetBus(bus_id));
+        }
+        graph_ = std::make_shared<graph::DirectedWeightedGraph<double>>(vertexes_amount);
+        edges_info_.clear();
+        edges_info_.reserve(old_edges_info.size());
+        for (graph::EdgeId edge_id = 0; edge_id < old_graph->GetEdgeCount(); ++edge_id) {
+            if (is_edge_kept[edge_id]) {
+                const graph::Edge<double>& edge = old_graph->GetEdge(edge_id);
+                AddEdge({new_vertex_ids[edge.from], new_vertex_ids[edge.to], edge.weight}, old_edges_info[edge_id]);
+            }
+        }
+        for (StopVertexes& stop_vertexes : stop_to_vertexes_ids_) {
+            stop_vertexes = StopVertexes{new_vertex_ids[stop_vertexes.in], new_vertex_ids[stop_vertexes.out]};
+        }
+
+        stop_to_vertexes_ids_.resize(catalogue.GetStopCount());
+        for (StopId stop_id = static_cast<StopId>(old_stop_count); stop_id < catalogue.GetStopCount(); ++stop_id) {
+            AddStopToGraph(catalogue.GetStop(stop_id), next_vertex_id);
+        }
+        for (const BusId bus_id : changed_buses) {
+            AddBusToGraph(catalogue, catalogue.GetBus(bus_id), next_vertex_id);
+        }
+
+        router_ = std::make_shared<const graph::Router<double>>(
+            *graph_,
+            route_settings_.router_mode,
+            route_settings_.router_thread_count
+        );
+    }
+
+    std::optional<TransportRouter::RouteView> TransportRouter::FindOptimalRoute(
         const Stop* stop_from,
         const Stop* stop_to
     ) const {
-        const std::optional<graph::Router<double>::RouteInfo> graph_route_info = router_->BuildRoute(
-            stop_to_vertexes_ids_.at(stop_from).in,
-            stop_to_vertexes_ids_.at(stop_to).in
+        std::optional<graph::Router<double>::RouteInfo> graph_route_info = router_->BuildRoute(
+            GetStopVertexes(stop_from).in,
+            GetStopVertexes(stop_to).in
+        );
+        if (!graph_route_info.has_value()) {
+            return std::nullopt;
+        }
+        return RouteView(graph_route_info.value().weight, std::move(graph_route_info.value().edges), edges_info_);
+    }
+
+    std::optional<TransportRouter::PointRoute> TransportRouter::FindOptimalRoute(
+        const std::vector<NearbyStop>& stops_from,
+        const std::vector<NearbyStop>& stops_to
+    ) const {
+        const double walk_velocity = route_settings_.walk_velocity * FROM_KM_H_TO_M_MIN;
+        auto make_vertexes = [this, walk_velocity](const std::vector<NearbyStop>& stops) {
+            std::vector<graph::Router<double>::WeightedVertex> vertexes;
+            vertexes.reserve(stops.size());
+            for (const NearbyStop& nearby_stop : stops) {
+                vertexes.push_back({GetStopVertexes(nearby_stop.stop).in, nearby_stop.distance / walk_velocity});
+            }
+            return vertexes;
+        };
+        std::optional<graph::Router<double>::MultiRouteInfo> graph_route_info = router_->BuildRoute(
+            make_vertexes(stops_from),
+            make_vertexes(stops_to)
         );
         if (!graph_route_info.has_value()) {
             return std::nullopt;
         }
-        std::vector<TransportRouter::EdgeInfo> optimal_route;
-        optimal_route.reserve(graph_route_info.value().edges.size());
-        for (graph::EdgeId edge_id : graph_route_info.value().edges) {
-            optimal_route.push_back(edge_id_to_edge_info_.at(edge_id));
+        const NearbyStop& stop_from = stops_from[graph_route_info->source_index];
+        const NearbyStop& stop_to = stops_to[graph_route_info->target_index];
+        return PointRoute{
+            stop_from.stop,
+            stop_from.distance / walk_velocity,
+            RouteView(graph_route_info->route.weight, std::move(graph_route_info->route.edges), edges_info_),
+            stop_to.stop,
+            stop_to.distance / walk_velocity
+        };
+    }
+
+    TransportRouter::RouteTimesMatrix TransportRouter::FindRouteTimes(
+        const std::vector<const Stop*>& stops_from,
+        const std::vector<const Stop*>& stops_to
+    ) const {
+        std::vector<graph::VertexId> sources;
+        sources.reserve(stops_from.size());
+        for (const Stop* stop : stops_from) {
+            sources.push_back(GetStopVertexes(stop).in);
+        }
+        std::vector<graph::VertexId> targets;
+        targets.reserve(stops_to.size());
+        for (const Stop* stop : stops_to) {
+            targets.push_back(GetStopVertexes(stop).in);
         }
-        return std::pair{optimal_route, graph_route_info.value().weight};
+        return router_->BuildWeightsMatrix(sources, targets);
     }
 } // namespace transport
\ No newline at end of file
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
 #include <memory>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -13,10 +15,22 @@
 
 namespace transport
 {
+    // Модель графа для автобусных маршрутов
+    enum class BusGraphModel {
+        STOP_PAIRS,    // Ребро на каждую пару остановок маршрута: O(k^2) рёбер на маршрут из k остановок
+        RIDE_VERTICES, // Вершина-поездка на каждую остановку маршрута с рёбрами посадки,
+                       // перегона и высадки: O(k) вершин и рёбер
+    };
+
     struct TransportRouteSettings
     {
         int bus_wait_time = 0;
         double bus_velocity = 0;
+        BusGraphModel bus_graph_model = BusGraphModel::STOP_PAIRS;
+        graph::RouterMode router_mode = graph::RouterMode::ALL_PAIRS;
+        size_t router_thread_count = 1;
+        double walk_velocity = 5.0; // Скорость пешехода в км/ч
+        size_t walk_stop_count = 5; // Сколько ближайших остановок рассматривать около точки
     };
 
     class TransportRouter {
@@ -34,25 +48,129 @@ namespace transport
         };
 
         using EdgeInfo = std::variant<WaitEdgeInfo, BusEdgeInfo>;
-        using CompleteRouteInfo = std::optional<std::pair<std::vector<EdgeInfo>, double>>;
+
+        // Найденный маршрут: общее время и номера рёбер пути. Сведения о рёбрах не копируются,
+        // а берутся из таблицы маршрутизатора, поэтому маршрут действителен, пока жив TransportRouter
+        class RouteView {
+        public:
+            double GetTotalTime() const {
+                return total_time_;
+            }
+
+            std::span<const graph::EdgeId> GetEdges() const {
+                return edges_;
+            }
+
+            const EdgeInfo& GetEdgeInfo(graph::EdgeId edge_id) const {
+                return (*edges_info_)[edge_id];
+            }
+
+            // Вызывает action для каждого элемента маршрута. Подряд идущие рёбра автобуса —
+            // части одной поездки без пересадки, они передаются одним BusEdgeInfo
+            template <typename Action>
+            void ForEachItem(Action action) const;
+
+        private:
+            friend class TransportRouter;
+
+            RouteView(double total_time, std::vector<graph::EdgeId> edges, const std::vector<EdgeInfo>& edges_info)
+            : total_time_(total_time), edges_(std::move(edges)), edges_info_(&edges_info)
+            {
+
+            }
+
+            double total_time_;
+            std::vector<graph::EdgeId> edges_;
+            const std::vector<EdgeInfo>* edges_info_;
+        };
+
+        // Маршрут между точками на карте: пешком до остановки, от неё на автобусах, затем пешком до точки
+        struct PointRoute {
+            const Stop* stop_from;
+            double walk_time_from;
+            RouteView route;
+            const Stop* stop_to;
+            double walk_time_to;
+
+            double GetTotalTime() const {
+                return walk_time_from + route.GetTotalTime() + walk_time_to;
+            }
+        };
+
+        using RouteTimesMatrix = std::vector<std::vector<std::optional<double>>>;
         
         explicit TransportRouter(TransportRouteSettings route_settings, const TransportCatalogue& catalogue) 
         :route_settings_(std::move(route_settings))
         {
-            std::set<const Stop*, StopComparator> sorted_stops = catalogue.GetStopsSortedByName();
-            graph_ = graph::DirectedWeightedGraph<double>(2 * sorted_stops.size());
+            const std::span<const Stop* const> sorted_stops = catalogue.GetStopsSortedByName();
+            graph_ = std::make_shared<graph::DirectedWeightedGraph<double>>(CountVertexes(sorted_stops.size(), catalogue));
+            stop_to_vertexes_ids_.resize(catalogue.GetStopCount());
 
-            AddStopsToGraph(sorted_stops);
-            AddBusesToGraph(catalogue);
+            graph::VertexId next_vertex_id = 0;
+            for (const Stop* stop : sorted_stops) {
+                AddStopToGraph(stop, next_vertex_id);
+            }
+            for (const Bus* bus : catalogue.GetBusesSortedByName()) {
+                AddBusToGraph(catalogue, bus, next_vertex_id);
+            }
 
-            router_ = std::make_unique<graph::Router<double>>(graph_);
+            router_ = std::make_shared<const graph::Router<double>>(
+                *graph_,
+                route_settings_.router_mode,
+                route_settings_.router_thread_count
+            );
         }
+
+        // Копия other для catalogue — копии справочника, по которому построен other. Граф и таблицы
+        // маршрутизатора не копируются, а делятся с other до первого Update копии; сведения о рёбрах
+        // копируются и ссылаются на остановки и автобусы catalogue
+        TransportRouter(const TransportRouter& other, const TransportCatalogue& catalogue);
+        TransportRouter(const TransportRouter&) = delete;
+        TransportRouter& operator=(const TransportRouter&) = delete;
         
-        CompleteRouteInfo FindOptimalRoute(
+        std::optional<RouteView> FindOptimalRoute(
             const Stop* stop_from,
             const Stop* stop_to
         ) const;
 
+        // Самый быстрый маршрут от любой из stops_from до любой из stops_to с учётом времени
+        // пешком до них. Все пары остановок перебираются одним поиском по графу
+        std::optional<PointRoute> FindOptimalRoute(
+            const std::vector<NearbyStop>& stops_from,
+            const std::vector<NearbyStop>& stops_to
+        ) const;
+
+        // Время в пути от каждой остановки stops_from до каждой остановки stops_to без восстановления маршрутов.
+        // Отсутствующее значение означает, что маршрута нет
+        RouteTimesMatrix FindRouteTimes(
+            const std::vector<const Stop*>& stops_from,
+            const std::vector<const Stop*>& stops_to
+        ) const;
+
+        // Применяет изменения справочника: добавляет вершины новых остановок и заменяет рёбра только
+        // автобусов changed_buses (см. TransportCatalogue::TakeChangedBuses), остальные рёбра переносятся
+        // как есть, что тоже линейно по размеру графа. Затем маршрутизатор заново строится по всему графу:
+        // в режиме DIJKSTRA это CSR-представление за O(V + E), в режимах ALL_PAIRS и ALL_PAIRS_BLOCKED —
+        // полный предподсчёт за O(V^3), в CONTRACTION_HIERARCHIES — стягивание всех вершин.
+        // Вершины поездок изменённых и удалённых автобусов в модели RIDE_VERTICES удаляются, а остальные
+        // вершины нумеруются заново подряд, поэтому граф и таблицы маршрутизатора не растут от обновления к обновлению
+        void Update(const TransportCatalogue& catalogue, std::span<const BusId> changed_buses);
+
+        const TransportRouteSettings& GetSettings() const {
+            return route_settings_;
+        }
+
+        // Сохраняет граф, сведения о рёбрах и таблицы маршрутизатора.
+        // Помимо Write/WriteVector, Archive должен уметь записывать ссылки на остановки и автобусы
+        // (WriteStop/WriteBus), а при чтении — восстанавливать их (ReadStop/ReadBus)
+        template <typename Archive>
+        void Save(Archive& archive) const;
+
+        // Восстанавливает маршрутизатор: граф собирается из сохранённых рёбер, таблицы маршрутизатора
+        // читаются из архива, предподсчёт маршрутов не повторяется
+        template <typename Archive>
+        static std::unique_ptr<TransportRouter> Load(Archive& archive);
+
     private:
         static constexpr double FROM_KM_H_TO_M_MIN = 100.0 / 6.0; // Константа для перевода из км/ч в м/мин
 
@@ -61,19 +179,150 @@ namespace transport
             graph::VertexId out;
         };
 
+        TransportRouter() = default;
+
         TransportRouteSettings route_settings_;
-        graph::DirectedWeightedGraph<double> graph_;
-        std::unique_ptr<graph::Router<double>> router_;
-        std::unordered_map<const Stop*, StopVertexes> stop_to_vertexes_ids_;
-        std::unordered_map<graph::EdgeId, EdgeInfo> edge_id_to_edge_info_;
+        // Граф и маршрутизатор могут быть общими с копиями TransportRouter, поэтому после построения
+        // не меняются: Update строит новые. Маршрутизатор ссылается на граф и объявлен после него
+        std::shared_ptr<graph::DirectedWeightedGraph<double>> graph_;
+        std::shared_ptr<const graph::Router<double>> router_;
+        std::vector<StopVertexes> stop_to_vertexes_ids_; // Индекс — StopId
+        std::vector<EdgeInfo> edges_info_; // Индекс — номер ребра в graph_
 
-        void AddStopsToGraph(
-            const std::set<const Stop*, StopComparator>& sorted_stops
-        );
+        const StopVertexes& GetStopVertexes(const Stop* stop) const;
+        void AddEdge(const graph::Edge<double>& edge, const EdgeInfo& edge_info);
 
-        void AddBusesToGraph(
+        size_t CountVertexes(
+            size_t stops_amount,
             const TransportCatalogue& catalogue
+        ) const;
+
+        size_t CountRideVertexes(
+            const Bus* bus
+        ) const;
+
+        void AddStopToGraph(
+            const Stop* stop,
+            graph::VertexId& next_vertex_id
+        );
+
+        void AddBusToGraph(
+            const TransportCatalogue& catalogue,
+            const Bus* bus,
+            graph::VertexId& next_vertex_id
+        );
+
+        void AddBusStopPairsToGraph(
+            const TransportCatalogue& catalogue,
+            const Bus* bus
+        );
+
+        void AddBusRideToGraph(
+            const TransportCatalogue& catalogue,
+            const Bus* bus,
+            const std::vector<const Stop*>& ride_stops,
+            graph::VertexId& next_vertex_id
         );
     };
+
+    template <typename Action>
+    void TransportRouter::RouteView::ForEachItem(Action action) const {
+        std::optional<BusEdgeInfo> ride_info;
+        for (const graph::EdgeId edge_id : edges_) {
+            const EdgeInfo& edge_info = GetEdgeInfo(edge_id);
+            if (const auto* bus_info = std::get_if<BusEdgeInfo>(&edge_info)) {
+                if (ride_info) {
+                    ride_info->span_count += bus_info->span_count;
+                    ride_info->time += bus_info->time;
+                } else {
+                    ride_info = *bus_info;
+                }
+                continue;
+            }
+            if (ride_info) {
+                action(EdgeInfo(*ride_info));
+                ride_info.reset();
+            }
+            action(edge_info);
+        }
+        if (ride_info) {
+            action(EdgeInfo(*ride_info));
+        }
+    }
+
+    template <typename Archive>
+    void TransportRouter::Save(Archive& archive) const {
+        archive.Write(route_settings_.bus_wait_time);
+        archive.Write(route_settings_.bus_velocity);
+        archive.Write(route_settings_.bus_graph_model);
+        archive.Write(static_cast<uint64_t>(route_settings_.router_thread_count));
+        archive.Write(route_settings_.walk_velocity);
+        archive.Write(static_cast<uint64_t>(route_settings_.walk_stop_count));
+
+        std::vector<graph::Edge<double>> edges;
+        edges.reserve(graph_->GetEdgeCount());
+        for (graph::EdgeId edge_id = 0; edge_id < graph_->GetEdgeCount(); ++edge_id) {
+            edges.push_back(graph_->GetEdge(edge_id));
+        }
+        archive.Write(static_cast<uint64_t>(graph_->GetVertexCount()));
+        archive.WriteVector(edges);
+
+        archive.WriteVector(stop_to_vertexes_ids_);
+
+        for (graph::EdgeId edge_id = 0; edge_id < graph_->GetEdgeCount(); ++edge_id) {
+            const EdgeInfo& edge_info = edges_info_[edge_id];
+            archive.Write(static_cast<uint8_t>(edge_info.index()));
+            if (const auto* wait_info = std::get_if<WaitEdgeInfo>(&edge_info)) {
+                archive.WriteStop(wait_info->stop);
+                archive.Write(wait_info->bus_wait_time);
+            } else {
+                const BusEdgeInfo& bus_info = std::get<BusEdgeInfo>(edge_info);
+                archive.WriteBus(bus_info.bus);
+                archive.Write(static_cast<uint64_t>(bus_info.span_count));
+                archive.Write(bus_info.time);
+            }
+        }
+
+        router_->Save(archive);
+    }
+
+    template <typename Archive>
+    std::unique_ptr<TransportRouter> TransportRouter::Load(Archive& archive) {
+        std::unique_ptr<TransportRouter> transport_router(new TransportRouter());
+        TransportRouteSettings& route_settings = transport_router->route_settings_;
+        route_settings.bus_wait_time = archive.template Read<int>();
+        route_settings.bus_velocity = archive.template Read<double>();
+        route_settings.bus_graph_model = archive.template Read<BusGraphModel>();
+        // Число потоков нужно, когда Update заново строит таблицы маршрутизатора
+        route_settings.router_thread_count = archive.template Read<uint64_t>();
+        route_settings.walk_velocity = archive.template Read<double>();
+        route_settings.walk_stop_count = archive.template Read<uint64_t>();
+
+        const size_t vertex_count = archive.template Read<uint64_t>();
+        const std::vector<graph::Edge<double>> edges = archive.template ReadVector<graph::Edge<double>>();
+        transport_router->graph_ = std::make_shared<graph::DirectedWeightedGraph<double>>(vertex_count);
+        for (const graph::Edge<double>& edge : edges) {
+            transport_router->graph_->AddEdge(edge);
+        }
+
+        transport_router->stop_to_vertexes_ids_ = archive.template ReadVector<StopVertexes>();
+
+        std::vector<EdgeInfo>& edges_info = transport_router->edges_info_;
+        edges_info.reserve(edges.size());
+        for (size_t i = 0; i < edges.size(); ++i) {
+            if (archive.template Read<uint8_t>() == 0) {
+                const Stop* stop = archive.ReadStop();
+                edges_info.push_back(WaitEdgeInfo{stop, archive.template Read<double>()});
+            } else {
+                const Bus* bus = archive.ReadBus();
+                const size_t span_count = archive.template Read<uint64_t>();
+                edges_info.push_back(BusEdgeInfo{bus, span_count, archive.template Read<double>()});
+            }
+        }
+
+        transport_router->router_ = std::make_shared<const graph::Router<double>>(archive, *transport_router->graph_);
+        route_settings.router_mode = transport_router->router_->GetMode();
+        return transport_router;
+    }
     
 } // namespace transport